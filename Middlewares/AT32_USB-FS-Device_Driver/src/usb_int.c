@@ -29,10 +29,6 @@
 __IO uint16_t SaveRState;
 __IO uint16_t SaveTState;
 
-/* Extern variables ----------------------------------------------------------*/
-extern void (*pEpInt_IN[7])(void);    /*  Handles IN  interrupts   */
-extern void (*pEpInt_OUT[7])(void);   /*  Handles OUT interrupts   */
-
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
@@ -157,6 +153,18 @@ void CTR_HP(void)
     _SetINTSTS((uint16_t)CLR_CTFR); /* clear CTR flag */
     /* extract highest priority endpoint number */
     EPindex = (uint8_t)(wIstr & INTSTS_EP_ID);
+#if UVC_FAST_CTR_HP
+    /* busiest IN endpoint, its routine is called directly instead of via pEpInt_IN */
+    if (EPindex == UVC_FAST_CTR_HP_EP)
+    {
+      if ((_GetENDPOINT(EPindex) & EP_CTFR_TX) != 0)
+      {
+        _ClearEP_CTFR_TX(EPindex);
+        UVC_FAST_CTR_HP_CALLBACK();
+      }
+      continue;
+    }
+#endif
     if ( EPindex == 0 )
         return;
     /* process related endpoint register */
@@ -32,6 +32,9 @@
 
 /**
   * @brief  Copy a buffer from user memory area to packet memory area (PMA).
+  *         PMA holds one halfword per 32-bit word. Word aligned buffers are
+  *         read 32 bits at a time and unrolled by 8 bytes, halfword aligned
+  *         buffers by 4 halfwords, any other buffer is assembled bytewise.
   * @param  pbUsrBuf:  pointer to user memory area. 
   * @param  wPMABufAddr:  address into PMA.   
   * @param  wNBytes:  number of bytes to be copied.    
@@ -39,11 +42,38 @@
   */
 void UserToPMABufferCopy(uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes)
 {
-  uint32_t n = (wNBytes + 1) >> 1;   /* n = (wNBytes + 1) / 2 */
-  uint32_t i, temp1, temp2;
+  uint32_t n = wNBytes;
+  uint32_t temp1, temp2;
   uint16_t *pdwVal;
   pdwVal = (uint16_t *)(wPMABufAddr * 2 + PMAAddr);
-  for (i = n; i != 0; i--)
+
+  if (((uint32_t)pbUsrBuf & 3) == 0)
+  {
+    for (; n >= 8; n -= 8)
+    {
+      temp1 = *(uint32_t *)pbUsrBuf;
+      temp2 = *(uint32_t *)(pbUsrBuf + 4);
+      pdwVal[0] = (uint16_t)temp1;
+      pdwVal[2] = (uint16_t)(temp1 >> 16);
+      pdwVal[4] = (uint16_t)temp2;
+      pdwVal[6] = (uint16_t)(temp2 >> 16);
+      pdwVal += 8;
+      pbUsrBuf += 8;
+    }
+  }
+  else if (((uint32_t)pbUsrBuf & 1) == 0)
+  {
+    for (; n >= 8; n -= 8)
+    {
+      pdwVal[0] = ((uint16_t *)pbUsrBuf)[0];
+      pdwVal[2] = ((uint16_t *)pbUsrBuf)[1];
+      pdwVal[4] = ((uint16_t *)pbUsrBuf)[2];
+      pdwVal[6] = ((uint16_t *)pbUsrBuf)[3];
+      pdwVal += 8;
+      pbUsrBuf += 8;
+    }
+  }
+  for (; n >= 2; n -= 2)
   {
     temp1 = (uint16_t) * pbUsrBuf;
     pbUsrBuf++;
@@ -52,10 +82,17 @@ void UserToPMABufferCopy(uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNByt
     pdwVal++;
     pbUsrBuf++;
   }
+  if (n)
+  {
+    *pdwVal = *pbUsrBuf;
+  }
 }
 
 /**
   * @brief  Copy a buffer from packet memory area (PMA) to user memory area.
+  *         Word aligned buffers get two PMA halfwords merged into one 32-bit
+  *         store, halfword aligned buffers halfword stores, both unrolled by
+  *         8 bytes. Only wNBytes are written, an odd tail is stored bytewise.
   * @param  pbUsrBuf:  pointer to user memory area. 
   * @param  wPMABufAddr:  address into PMA.   
   * @param  wNBytes:  number of bytes to be copied.    
@@ -63,14 +100,42 @@ void UserToPMABufferCopy(uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNByt
   */
 void PMAToUserBufferCopy(uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes)
 {
-  uint32_t n = (wNBytes + 1) >> 1;/* /2*/
-  uint32_t i;
+  uint32_t n = wNBytes;
+  uint32_t temp;
   uint32_t *pdwVal;
   pdwVal = (uint32_t *)(wPMABufAddr * 2 + PMAAddr);
-  for (i = n; i != 0; i--)
+
+  if (((uint32_t)pbUsrBuf & 3) == 0)
   {
-    *(uint16_t*)pbUsrBuf++ = *pdwVal++;
-    pbUsrBuf++;
+    for (; n >= 8; n -= 8)
+    {
+      ((uint32_t *)pbUsrBuf)[0] = (pdwVal[0] & 0xFFFF) | (pdwVal[1] << 16);
+      ((uint32_t *)pbUsrBuf)[1] = (pdwVal[2] & 0xFFFF) | (pdwVal[3] << 16);
+      pdwVal += 4;
+      pbUsrBuf += 8;
+    }
+  }
+  else if (((uint32_t)pbUsrBuf & 1) == 0)
+  {
+    for (; n >= 8; n -= 8)
+    {
+      ((uint16_t *)pbUsrBuf)[0] = pdwVal[0];
+      ((uint16_t *)pbUsrBuf)[1] = pdwVal[1];
+      ((uint16_t *)pbUsrBuf)[2] = pdwVal[2];
+      ((uint16_t *)pbUsrBuf)[3] = pdwVal[3];
+      pdwVal += 4;
+      pbUsrBuf += 8;
+    }
+  }
+  for (; n >= 2; n -= 2)
+  {
+    temp = *pdwVal++;
+    *pbUsrBuf++ = (uint8_t)temp;
+    *pbUsrBuf++ = (uint8_t)(temp >> 8);
+  }
+  if (n)
+  {
+    *pbUsrBuf = (uint8_t)*pdwVal;
   }
 }
 
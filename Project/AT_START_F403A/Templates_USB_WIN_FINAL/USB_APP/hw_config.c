@@ -25,6 +25,8 @@
 #include "usb_desc.h"
 #include "usb_pwr.h"
 #include "at32_board.h"
+#include "uvcstream.h"
+#include "uacstream.h"
 
 /** @addtogroup AT32F413_StdPeriph_Examples
   * @{
@@ -46,8 +48,12 @@ int ACC_C2_value=0;
 
 /* Extern variables ----------------------------------------------------------*/
 
+volatile u32 Resume_LastUs = 0;
+volatile u32 Resume_MaxUs = 0;
+volatile u32 Resume_OverBudgetCnt = 0;
 /* Extern variables ----------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
+static void SYSCLK_Restore(void);
 /* Private functions ---------------------------------------------------------*/
 
 /**
@@ -119,6 +125,9 @@ void Set_USBClock(u8 Clk_Source)
 /*******************************************************************************
 * Function Name  : Enter_LowPowerMode.
 * Description    : Power-off system clocks and power while entering suspend mode.
+*                  Called from the USB interrupt, the sensor and codec are shut
+*                  down and STOP is entered from the main loop, see
+*                  Suspend_Process(), so no SCCB transfer is cut in half.
 * Input          : None.
 * Output         : None.
 * Return         : None.
@@ -127,8 +136,97 @@ void Enter_LowPowerMode(void)
 {
   /* Set the device state to suspend */
   bDeviceState = SUSPENDED;
-  /* Request to enter STOP mode with regulator in low power mode */
-//  PWR_EnterSTOPMode(PWR_Regulator_LowPower, PWR_STOPEntry_WFI);
+}
+
+/*******************************************************************************
+* Function Name  : Suspend_Process.
+* Description    : Main loop part of USB suspend. Powers down the sensor and the
+*                  codec, then sleeps in STOP until the bus resumes. Any other
+*                  wake-up goes straight back to STOP.
+*                  Interrupts stay masked across STOP so the USB wake-up is only
+*                  serviced once the 192MHz clock and the 48MHz USB clock are back.
+* Input          : None.
+* Output         : None.
+* Return         : None.
+*******************************************************************************/
+void Suspend_Process(void)
+{
+  u32 t0, t1, us;
+
+  if (bDeviceState != SUSPENDED)
+  {
+    return;
+  }
+  UVC_Stream_Suspend();
+#if UAC_MIC_ENABLE
+  UAC_Stream_Suspend();
+#endif
+  AT32_LEDn_OFF(LED4);
+  RCC_APB1PeriphClockCmd(RCC_APB1PERIPH_PWR, ENABLE);
+
+  while (1)
+  {
+    __disable_irq();
+    if (bDeviceState != SUSPENDED)
+    {
+      __enable_irq();       /* resumed between two wake-ups */
+      break;
+    }
+    PWR_EnterSTOPMode(PWR_Regulator_LowPower, PWR_STOPEntry_WFI);
+    /* DWT counts HCLK: HSI until SYSCLK_Restore() switches, PLL after */
+    t0 = DWT->CYCCNT;
+    SYSCLK_Restore();
+    t1 = DWT->CYCCNT;
+    __enable_irq();         /* USB wake-up and resume are serviced here */
+    if (bDeviceState != SUSPENDED)
+    {
+      us = (t1 - t0) / (HSI_VALUE / 1000000) + (DWT->CYCCNT - t1) / (SystemCoreClock / 1000000);
+      Resume_LastUs = us;
+      if (us > Resume_MaxUs)
+      {
+        Resume_MaxUs = us;
+      }
+      if (us > USB_RESUME_BUDGET_US)
+      {
+        Resume_OverBudgetCnt++;
+      }
+      break;
+    }
+  }
+
+  UVC_Stream_Resume();
+#if UAC_MIC_ENABLE
+  UAC_Stream_Resume();
+#endif
+}
+
+/*******************************************************************************
+* Function Name  : SYSCLK_Restore.
+* Description    : STOP leaves the core on HSI with HSE and PLL off. The PLL
+*                  settings and bus prescalers are kept, so only HSE and PLL are
+*                  restarted and selected again, the USB clock follows the PLL.
+* Input          : None.
+* Output         : None.
+* Return         : None.
+*******************************************************************************/
+static void SYSCLK_Restore(void)
+{
+  RCC_HSEConfig(RCC_HSE_ENABLE);
+  if (RCC_WaitForHSEStable() != SUCCESS)
+  {
+    return;                 /* stay on HSI, USB will not work but the core runs */
+  }
+  RCC_PLLCmd(ENABLE);
+  while (RCC_GetFlagStatus(RCC_FLAG_PLLSTBL) == RESET)
+  {
+  }
+  /* switching to a PLL above 108MHz has to go through the step mode */
+  RCC_StepModeCmd(ENABLE);
+  RCC_SYSCLKConfig(RCC_SYSCLKSelction_PLL);
+  while (RCC_GetSYSCLKSelction() != 0x08)
+  {
+  }
+  RCC_StepModeCmd(DISABLE);
 }
 
 /*******************************************************************************
@@ -27,9 +27,18 @@
 #define USBCLK_FROM_HSE  1
 #define USBCLK_FROM_HSI  2
 
+//the host may send traffic 10ms after it stops driving resume (USB 2.0 7.1.7.7)
+//the device wakes at the start of the 20ms resume signalling, so this leaves margin
+#define USB_RESUME_BUDGET_US  10000
+
+extern volatile u32 Resume_LastUs;        //STOP exit to USB interrupts enabled, last resume
+extern volatile u32 Resume_MaxUs;
+extern volatile u32 Resume_OverBudgetCnt; //resumes longer than USB_RESUME_BUDGET_US
+
 void Set_USBClock(u8 Clk_Source);
 void Enter_LowPowerMode(void);
 void Leave_LowPowerMode(void);
+void Suspend_Process(void);
 void Get_SerialNum(void);
 void USB_Interrupts_Config(void);
 #endif  /*__HW_CONFIG_H*/
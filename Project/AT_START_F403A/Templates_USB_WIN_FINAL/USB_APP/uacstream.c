@@ -0,0 +1,184 @@
+#include "uacstream.h"
+#include "usb_lib.h"
+#include "usb_desc.h"
+#include "usb_mem.h"
+
+#if UAC_MIC_ENABLE
+#include "wm8988.h"
+#include "mic.h"
+
+
+volatile u8 UAC_State = UAC_STATE_OFF;     //written by the USB interrupt and UAC_Stream_Process()
+volatile u8 UAC_Mute = 0;
+volatile s16 UAC_Volume = 0;         //0dB
+static volatile u8 UAC_CtrlPending = 0;    //mute or volume set, codec not yet reprogrammed
+static u8 UAC_CodecOk = 0;           //WM8988 answered at init
+static u8 UAC_MicOn = 0;             //I2S capture running
+volatile u32 UAC_ShortPackCnt = 0;
+volatile u32 UAC_LongPackCnt = 0;
+volatile u32 UAC_StartErrCnt = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint16_t UAC_TxBuf(void);
+static void UAC_Codec_Apply(void);
+
+
+//codec and I2S capture, called once after OV2640_Init() which brings up the SCCB bus
+//a missing codec leaves the function enumerated, it then streams silence
+void UAC_Init(void)
+{
+    UAC_CodecOk = (WM8988_Init() == 0);
+    MIC_Init();
+}
+
+//EP2 IN completion, called from the USB interrupt
+//The free half gets the next packet: 16 samples, or 15/17 to pull the ring back to UAC_FIFO_TARGET.
+void UAC_SendPack_Irq(void)
+{
+    int16_t buf[UAC_PACKET_SAMPLES + 1];
+    uint16_t addr = UAC_TxBuf();
+    uint16_t level, n = 0;
+
+    switch (UAC_State)
+    {
+    case UAC_STATE_FILL:
+        if (MIC_Level() < UAC_FIFO_TARGET)
+            break;
+        UAC_State = UAC_STATE_BUSY;
+        //no break
+    case UAC_STATE_BUSY:
+        n = UAC_PACKET_SAMPLES;
+        level = MIC_Level();
+        if (level > UAC_FIFO_TARGET + UAC_FIFO_SLACK)
+        {
+            n++;
+            UAC_LongPackCnt++;
+        }
+        else if (level < UAC_FIFO_TARGET - UAC_FIFO_SLACK)
+        {
+            n--;
+            UAC_ShortPackCnt++;
+        }
+        n = MIC_Read(buf, n);
+        UserToPMABufferCopy((uint8_t*)buf, addr, n * UAC_SAMPLE_BYTES);
+        break;
+
+    default:
+        break;
+    }
+
+    if(addr == ENDP2_BUF0Addr)
+        SetEPDblBuf0Count(ENDP2, EP_DBUF_IN, n * UAC_SAMPLE_BYTES);
+    else
+        SetEPDblBuf1Count(ENDP2, EP_DBUF_IN, n * UAC_SAMPLE_BYTES);
+    _ToggleDTOG_RX(ENDP2);
+}
+static uint16_t UAC_TxBuf(void)
+{
+    if(_GetENDPOINT(ENDP2) & EP_DTOG_RX)
+        return ENDP2_BUF0Addr;
+    return ENDP2_BUF1Addr;
+}
+
+void UAC_SetAltSetting(u8 alt)
+{
+    if (alt == 0)
+        UAC_Stream_Stop();
+    else if (UAC_State == UAC_STATE_OFF)
+        UAC_State = UAC_STATE_READY;
+}
+
+void UAC_Stream_Stop(void)
+{
+    UAC_State = UAC_STATE_OFF;
+    _SetEPTxStatus(ENDP2, EP_TX_DIS);
+}
+
+//SET_CUR on mute or volume, called from the USB interrupt, the codec is written from the main loop
+void UAC_Control_Changed(void)
+{
+    UAC_CtrlPending = 1;
+}
+
+//Volume in 1/256dB maps onto the ADC digital volume in 0.5dB steps around 0xC3 (0dB)
+static void UAC_Codec_Apply(void)
+{
+    UAC_CtrlPending = 0;
+    if (UAC_CodecOk == 0)
+        return;
+    if (UAC_Mute)
+        WM8988_ADC_Volume(WM8988_ADC_VOL_MUTE);
+    else
+        WM8988_ADC_Volume(WM8988_ADC_VOL_0DB + UAC_Volume / UAC_VOLUME_RES);
+}
+
+//USB suspend, called from the main loop before STOP
+//a running stream is parked in READY so UAC_Stream_Process() restarts the capture after resume
+void UAC_Stream_Suspend(void)
+{
+    __disable_irq();
+    if (UAC_State != UAC_STATE_OFF)
+    {
+        UAC_Stream_Stop();
+        UAC_State = UAC_STATE_READY;
+    }
+    __enable_irq();
+    if (UAC_MicOn)
+    {
+        MIC_Stop();
+        UAC_MicOn = 0;
+    }
+    if (UAC_CodecOk)
+        WM8988_PowerDown();
+}
+
+//after the clocks are back, the codec keeps its settings and only needs power and MCLK
+void UAC_Stream_Resume(void)
+{
+    if (UAC_CodecOk)
+        WM8988_PowerUp();
+}
+
+void UAC_Stream_Process(void)
+{
+    if (UAC_CtrlPending)
+        UAC_Codec_Apply();
+
+    switch (UAC_State)
+    {
+    case UAC_STATE_OFF:
+        if (UAC_MicOn)
+        {
+            MIC_Stop();
+            UAC_MicOn = 0;
+        }
+        break;
+
+    case UAC_STATE_READY:
+        //no I2S clock from the codec: EP2 stays off until the host selects alt 1 again
+        if (MIC_Start() != 0)
+        {
+            MIC_Stop();
+            UAC_StartErrCnt++;
+            __disable_irq();
+            if (UAC_State == UAC_STATE_READY)
+                UAC_Stream_Stop();
+            __enable_irq();
+            break;
+        }
+        UAC_MicOn = 1;
+        __disable_irq();
+        if (UAC_State == UAC_STATE_READY)
+        {
+            UAC_State = UAC_STATE_FILL;
+            _SetEPTxStatus(ENDP2, EP_TX_VALID);
+        }
+        __enable_irq();
+        break;
+
+    default:
+        break;
+    }
+}
+
+#endif
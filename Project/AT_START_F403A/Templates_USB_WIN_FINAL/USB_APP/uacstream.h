@@ -0,0 +1,37 @@
+#ifndef 	_UACSTREAM_H_
+#define		_UACSTREAM_H_
+#include "at32f4xx.h"
+#include "usb_desc.h"
+
+#if UAC_MIC_ENABLE
+
+//streaming state, see UAC_Stream_Process()
+#define UAC_STATE_OFF           0
+#define UAC_STATE_READY         1           //alt 1 selected, the main loop starts the capture
+#define UAC_STATE_FILL          2           //EP2 sends empty packets until the ring reaches UAC_FIFO_TARGET
+#define UAC_STATE_BUSY          3
+
+//the codec clock and the USB SOF drift apart, the ring level is held around UAC_FIFO_TARGET
+//by sending one sample more or less per packet once it is UAC_FIFO_SLACK away
+#define UAC_FIFO_TARGET         MIC_LEVEL_TARGET
+#define UAC_FIFO_SLACK          UAC_PACKET_SAMPLES
+
+extern volatile u8 UAC_State;
+extern volatile u8 UAC_Mute;
+extern volatile s16 UAC_Volume;             //1/256dB, UAC_VOLUME_MIN..UAC_VOLUME_MAX
+extern volatile u32 UAC_ShortPackCnt;       //packets sent with one sample less
+extern volatile u32 UAC_LongPackCnt;        //packets sent with one sample more
+extern volatile u32 UAC_StartErrCnt;        //capture starts without WS from the codec
+
+void UAC_Init(void);
+void UAC_SendPack_Irq(void);
+void UAC_SetAltSetting(u8 alt);
+void UAC_Stream_Stop(void);
+void UAC_Control_Changed(void);
+void UAC_Stream_Process(void);
+void UAC_Stream_Suspend(void);
+void UAC_Stream_Resume(void);
+
+#endif
+
+#endif
@@ -0,0 +1,49 @@
+#include "usb_bench.h"
+#include "usb_desc.h"
+#include "usb_conf.h"
+#include "usb_mem.h"
+
+#if USB_MEM_BENCH
+#define USB_MEM_BENCH_ROOM      (ENDP1_BUF1Addr - ENDP1_BUF0Addr)   //bytes in EP1 buffer 0
+
+//per packet size: bytes, then cycles for UserToPMABufferCopy() from a word aligned and
+//an odd buffer, PMAToUserBufferCopy() to a word aligned and an odd buffer
+volatile u32 USB_MemBench[USB_MEM_BENCH_SIZES][5];
+static u32 USB_MemBenchBuf[USB_MEM_BENCH_ROOM / 4 + 2];
+#endif
+
+
+//Time the PMA copies with the DWT cycle counter through the EP1 buffer 0
+//Sizes: audio packet, bulk packet, isochronous alternates odd and even, each cut to the
+//room of the buffer. Read USB_MemBench with the debugger.
+//Call once after USB_Init(), EP1 stays idle until the host starts streaming.
+void USB_MemBench_Run(void)
+{
+#if USB_MEM_BENCH
+    static const u16 size[USB_MEM_BENCH_SIZES] = {34, 64, 175, 176, 256, 311, 312};
+    u8 *buf = (u8 *)USB_MemBenchBuf;
+    u32 i, n, t;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    __disable_irq();
+    for (i = 0; i < USB_MEM_BENCH_SIZES; i++)
+    {
+        n = (size[i] < USB_MEM_BENCH_ROOM) ? size[i] : USB_MEM_BENCH_ROOM;
+        USB_MemBench[i][0] = n;
+        t = DWT->CYCCNT;
+        UserToPMABufferCopy(buf, ENDP1_BUF0Addr, n);
+        USB_MemBench[i][1] = DWT->CYCCNT - t;
+        t = DWT->CYCCNT;
+        UserToPMABufferCopy(buf + 1, ENDP1_BUF0Addr, n);
+        USB_MemBench[i][2] = DWT->CYCCNT - t;
+        t = DWT->CYCCNT;
+        PMAToUserBufferCopy(buf, ENDP1_BUF0Addr, n);
+        USB_MemBench[i][3] = DWT->CYCCNT - t;
+        t = DWT->CYCCNT;
+        PMAToUserBufferCopy(buf + 1, ENDP1_BUF0Addr, n);
+        USB_MemBench[i][4] = DWT->CYCCNT - t;
+    }
+    __enable_irq();
+#endif
+}
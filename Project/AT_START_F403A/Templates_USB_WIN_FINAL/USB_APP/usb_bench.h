@@ -0,0 +1,17 @@
+#ifndef _USB_BENCH_H_
+#define _USB_BENCH_H_
+#include "at32f4xx.h"
+
+//measurement builds only: 1 times the PMA copy routines once at start up for the packet
+//sizes of the endpoints, see USB_MemBench_Run()
+#define USB_MEM_BENCH           0
+#define USB_MEM_BENCH_SIZES     7
+
+#if USB_MEM_BENCH
+extern volatile u32 USB_MemBench[USB_MEM_BENCH_SIZES][5];
+#endif
+
+void USB_MemBench_Run(void);
+
+
+#endif
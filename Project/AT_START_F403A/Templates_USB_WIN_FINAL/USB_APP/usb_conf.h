@@ -17,30 +17,86 @@
 #ifndef __USB_CONF_H
 #define __USB_CONF_H
 
+#include "at32f4xx.h"
+#include "usb_desc.h"
+
 /*-------------------------------------------------------------*/
 /* EP_NUM */
 /* defines how many endpoints are used by the device */
+/* EP0 control, EP1 video and EP2 audio, each one takes 8 bytes of BTABLE */
 /*-------------------------------------------------------------*/
+#if UAC_MIC_ENABLE
 #define EP_NUM                          (3)
+#else
+#define EP_NUM                          (2)
+#endif
 
 /*-------------------------------------------------------------*/
 /* --------------   Buffer Description Table  -----------------*/
 /*-------------------------------------------------------------*/
 /* buffer table base address */
-/* buffer table base address */
 #define BTABLE_ADDRESS      (0x00)
+/* packet memory size, Set_USB768ByteMode() in main() */
+#define USB_PMA_SIZE        (768)
+
+/* Endpoint buffers, X(name, type, direction, double buffered, max packet size) */
+/* Allocated in this order right after the BTABLE (8 bytes per endpoint). A control */
+/* endpoint gets an rx and a tx buffer, a double buffered one two of the same kind. */
+/* The build fails if they do not fit in USB_PMA_SIZE. */
+#if UAC_MIC_ENABLE
+#define USB_PMA_EP_LIST(X) \
+    X(ENDP0, USB_PMA_CTRL, USB_PMA_OUT, 0, CAMERA_EP0_PACKET_SIZE) \
+    X(ENDP1, USB_PMA_DATA, USB_PMA_IN,  1, VS_PACKET_SIZE_MAX) \
+    X(ENDP2, USB_PMA_DATA, USB_PMA_IN,  1, UAC_PACKET_SIZE_MAX)
+#else
+#define USB_PMA_EP_LIST(X) \
+    X(ENDP0, USB_PMA_CTRL, USB_PMA_OUT, 0, CAMERA_EP0_PACKET_SIZE) \
+    X(ENDP1, USB_PMA_DATA, USB_PMA_IN,  1, VS_PACKET_SIZE_MAX)
+#endif
+
+#define USB_PMA_CTRL        0
+#define USB_PMA_DATA        1           /* bulk, interrupt or isochronous */
+#define USB_PMA_OUT         0
+#define USB_PMA_IN          1
+
+/* rx buffers are counted in 2 byte blocks up to 62 bytes and in 32 byte blocks above */
+#define USB_PMA_RX_LEN(size)    (((size) > 62) ? (((size) + 31) & ~31) : (((size) + 1) & ~1))
+#define USB_PMA_TX_LEN(size)    (((size) + 1) & ~1)
+#define USB_PMA_BUF0_LEN(type, dir, size) \
+    ((((type) == USB_PMA_CTRL) || ((dir) == USB_PMA_OUT)) ? USB_PMA_RX_LEN(size) : USB_PMA_TX_LEN(size))
+#define USB_PMA_BUF1_LEN(type, dir, dbl, size) \
+    (((type) == USB_PMA_CTRL) ? USB_PMA_TX_LEN(size) : ((dbl) ? USB_PMA_BUF0_LEN(type, dir, size) : 0))
+
+/* every enumerator follows the last byte of the one before it */
+#define USB_PMA_EP_ENUM(name, type, dir, dbl, size) \
+    name##_PMA_BUF0, \
+    name##_PMA_BUF0_LAST = name##_PMA_BUF0 + USB_PMA_BUF0_LEN(type, dir, size) - 1, \
+    name##_PMA_BUF1, \
+    name##_PMA_BUF1_LAST = name##_PMA_BUF1 + USB_PMA_BUF1_LEN(type, dir, dbl, size) - 1,
+enum
+{
+  USB_PMA_BTABLE_LAST = BTABLE_ADDRESS + 8 * EP_NUM - 1,
+  USB_PMA_EP_LIST(USB_PMA_EP_ENUM)
+  USB_PMA_END
+};
+typedef char USB_PMA_SizeCheck[(USB_PMA_END <= USB_PMA_SIZE) ? 1 : -1];
 
 /* EP0  */
 /* rx/tx buffer base address */
-#define ENDP0_RXADDR        (0x10)
-#define ENDP0_TXADDR        (0x50)
+#define ENDP0_RXADDR        ENDP0_PMA_BUF0
+#define ENDP0_TXADDR        ENDP0_PMA_BUF1
 
 /* EP1  */
-/* tx buffer base address */
-#define ENDP1_BUF0Addr      (0x90)
-#define ENDP1_BUF1Addr      (0x90+PACKET_SIZE)
+/* tx buffer base address, sized for the largest alternate setting */
+#define ENDP1_BUF0Addr      ENDP1_PMA_BUF0
+#define ENDP1_BUF1Addr      ENDP1_PMA_BUF1
 
-#define ENDP2_TXADDR        (0x90+2*PACKET_SIZE)
+#if UAC_MIC_ENABLE
+/* EP2  */
+/* tx buffer base address, microphone */
+#define ENDP2_BUF0Addr      ENDP2_PMA_BUF0
+#define ENDP2_BUF1Addr      ENDP2_PMA_BUF1
+#endif
 
 /*-------------------------------------------------------------*/
 /* -------------------   ISTR events  -------------------------*/
@@ -49,7 +105,8 @@
 /* mask defining which events has to be handled */
 /* by the device application software */
 //#define IMR_MSK (CNTR_CTRM  | CNTR_SOFM  | CNTR_RESETM )
-#define IMR_MSK (CTRL_CTFR_IEN  | CTRL_RST_IEN)
+/* SUSP/WKUP drive Suspend_Process(), see hw_config.c */
+#define IMR_MSK (CTRL_CTFR_IEN  | CTRL_SOF_IEN  | CTRL_RST_IEN | CTRL_SUSP_IEN | CTRL_WKUP_IEN)
 
 
 /*#define CTR_CALLBACK*/
@@ -58,13 +115,30 @@
 /*#define WKUP_CALLBACK*/
 /*#define SUSP_CALLBACK*/
 /*#define RESET_CALLBACK*/
-/*#define SOF_CALLBACK*/
+#define SOF_CALLBACK
 /*#define ESOF_CALLBACK*/
 
+/* high priority CTR: 1 makes CTR_HP() call UVC_FAST_CTR_HP_CALLBACK directly for the */
+/* video endpoint, 0 leaves it to pEpInt_IN like every other endpoint */
+#define UVC_FAST_CTR_HP     1
+#if UVC_FAST_CTR_HP
+#define UVC_FAST_CTR_HP_EP        1
+#define UVC_FAST_CTR_HP_CALLBACK  UVC_SendPack_Irq
+void UVC_SendPack_Irq(void);
+#endif
+
+/* measurement builds only: 1 keeps a cycle histogram of the high priority interrupt, */
+/* see UVC_IrqHist_Add(). Bin n counts interrupts that took [2^n, 2^(n+1)) SYSCLK cycles, */
+/* the last bin everything above */
+#define UVC_IRQ_HIST        0
+#define UVC_IRQ_HIST_BINS   16
+
 /* CTR service routines */
 /* associated to defined endpoints */
 //#define  EP1_IN_Callback   NOP_Process
+#if !UAC_MIC_ENABLE
 #define  EP2_IN_Callback   NOP_Process
+#endif
 #define  EP3_IN_Callback   NOP_Process
 #define  EP4_IN_Callback   NOP_Process
 #define  EP5_IN_Callback   NOP_Process
@@ -21,7 +21,7 @@ const u8 Camera_DeviceDescriptor[] =
     0xEF,                                 /* bDeviceClass */
     0x02,                                 /* bDeviceSubClass */
     0x01,                                 /* bDeviceProtocol */
-    0x40,                                 /* bMaxPacketSize 40 */
+    CAMERA_EP0_PACKET_SIZE,               /* bMaxPacketSize */
     0xF2,                                 /* idVendor = 0x1985*/
     0x04,
     0x08,                                 /* idProduct  = 0x1017*/
@@ -34,22 +34,77 @@ const u8 Camera_DeviceDescriptor[] =
     0x01                                  /* bNumConfigurations */
   };
 
+/* Descriptor builders, expanded over the lists in usb_desc.h */
+#define UVC_INTERVAL_BYTES(interval)    MAKE_DWORD(interval),
+
+/* Class-specific VideoStream MJPEG Frame Descriptor */
+#define UVC_MJPEG_FRAME_DESC(index, width, height, size) \
+    VS_FRAME_DESC_SIZE(VS_NUM_INTERVALS), /* bLength */ \
+    0x24,                                 /* bDescriptorType : CS_INTERFACE */ \
+    0x07,                                 /* bDescriptorSubType : VS_FRAME_MJPEG */ \
+    index,                                /* bFrameIndex */ \
+    0x02,                                 /* bmCapabilities : D1: Fixed frame-rate. */ \
+    MAKE_WORD(width),                     /* wWidth : Width of frame, pixels. */ \
+    MAKE_WORD(height),                    /* wHeight : Height of frame, pixels. */ \
+    MAKE_DWORD(MIN_BIT_RATE(size)),       /* dwMinBitRate : Min bit rate in bits/s  */ \
+    MAKE_DWORD(MAX_BIT_RATE(size)),       /* dwMaxBitRate : Max bit rate in bits/s  */ \
+    MAKE_DWORD(size),                     /* dwMaxVideoFrameBufSize : Maximum video or still frame size, in bytes. */ \
+    MAKE_DWORD(FRAME_INTERVEL),           /* dwDefaultFrame Interval time, unit=100ns */ \
+    VS_NUM_INTERVALS,                     /* bFrameIntervalType : Discrete frame intervals */ \
+    VS_MJPEG_INTERVAL_LIST(UVC_INTERVAL_BYTES)  /* dwFrameInterval(n) */
+
+/* Class-specific VideoStream Uncompressed Frame Descriptor */
+#define UVC_YUY2_FRAME_DESC(index, width, height, size) \
+    VS_FRAME_DESC_SIZE(VS_YUY2_NUM_INTERVALS), /* bLength */ \
+    0x24,                                 /* bDescriptorType : CS_INTERFACE */ \
+    0x05,                                 /* bDescriptorSubType : VS_FRAME_UNCOMPRESSED */ \
+    index,                                /* bFrameIndex */ \
+    0x02,                                 /* bmCapabilities : D1: Fixed frame-rate. */ \
+    MAKE_WORD(width),                     /* wWidth : Width of frame, pixels. */ \
+    MAKE_WORD(height),                    /* wHeight : Height of frame, pixels. */ \
+    MAKE_DWORD(YUY2_BIT_RATE(size, VS_YUY2_INTERVAL_MAX)),   /* dwMinBitRate : Min bit rate in bits/s  */ \
+    MAKE_DWORD(YUY2_BIT_RATE(size, VS_YUY2_INTERVAL_MIN)),   /* dwMaxBitRate : Max bit rate in bits/s  */ \
+    MAKE_DWORD(size),                     /* dwMaxVideoFrameBufSize : Maximum video frame size, in bytes. */ \
+    MAKE_DWORD(VS_YUY2_INTERVAL_MIN),     /* dwDefaultFrame Interval time, unit=100ns */ \
+    VS_YUY2_NUM_INTERVALS,                /* bFrameIntervalType : Discrete frame intervals */ \
+    VS_YUY2_INTERVAL_LIST(UVC_INTERVAL_BYTES)   /* dwFrameInterval(n) */
+
+/* Operational alternate setting of the VideoStream interface and its isochronous endpoint */
+#define UVC_ALT_SETTING_DESC(alt, size) \
+    USB_INTERFACE_DESC_SIZE,            /* Size of this descriptor, in bytes. */ \
+    0x04,                               /* INTERFACE descriptor type */ \
+    0x01,                               /* Index of this interface */ \
+    alt,                                /* Index of this alternate setting */ \
+    0x01,                               /* endpoints */ \
+    0x0e,                               /* CC_VIDEO */ \
+    0x02,                               /* SC_VIDEOSTREAMING */ \
+    0x00,                               /* PC_PROTOCOL_UNDEFINED */ \
+    0x00,                               /* Unused */ \
+    USB_ENDPOINT_DESC_SIZE,             /* Size of this descriptor, in bytes. */ \
+    0x05,                               /* ENDPOINT */ \
+    0x81,                               /* IN endpoint 1 */ \
+    0x05,                               /* Isochronous transfer type. Asynchronous synchronization type. */ \
+    MAKE_WORD(size),                    /* Max packet size, in bytes */ \
+    0x01,                               /* One frame interval */
+
+/* Table builders */
+#define UVC_FRAME_ENTRY(index, width, height, size)     {width, height, size},
+#define UVC_INTERVAL_ENTRY(interval)                    interval,
+
 const u8 Camera_ConfigDescriptor[] =
   {
     /* Configuration Descriptor */
-    0x09,                                /* bLength */
+    USB_CONFIG_DESC_SIZE,                /* bLength */
     USB_CONFIGURATION_DESCRIPTOR_TYPE,   /* bDescriptorType */
-    CAMERA_SIZ_CONFIG_DESC,              /* wTotalLength  0x90 bytes*/
-    0x00,
-    0x02,                                 /* bNumInterfaces */
+    MAKE_WORD(CAMERA_SIZ_CONFIG_DESC),   /* wTotalLength */
+    CAMERA_NUM_INTERFACES,                /* bNumInterfaces */
     0x01,                                 /* bConfigurationValue */
     0x00,                                 /* iConfiguration */
     0x80,                                 /* bmAttributes  BUS Powred, no remote wakeup*/
     0xFA,                                 /* bMaxPower = 500 mA*/
-    /* 09 byte, total size 9*/
 
     /* 1. Standard Video Interface Collection IAD */
-    0x08,                                 /* bLength */
+    USB_IAD_DESC_SIZE,                    /* bLength */
     USB_ASSOCIATION_DESCRIPTOR_TYPE,      /* bDescriptorType */
     0x00,                                 /* bFirstInterface: Interface number of the VideoControl interface that is associated with this function*/
     0x02,                                 /* Number of contiguous Video interfaces that are associated with this function */
@@ -57,10 +112,9 @@ const u8 Camera_ConfigDescriptor[] =
     0x03,                                 /* bFunction sub Class: SC_VIDEO_INTERFACE_COLLECTION */
     0x00,                                 /* bFunction protocol : PC_PROTOCOL_UNDEFINED*/
     0x02,                                 /* iFunction */
-    /* 08 bytes, total size 17*/
 
     /* 2. Standard VideoControl Interface Descriptor */
-    0x09,                                 /* bLength */
+    USB_INTERFACE_DESC_SIZE,              /* bLength */
     0x04,                                 /* bDescriptorType */
     0x00,                                 /* bInterfaceNumber */
     0x00,                                 /* bAlternateSetting */
@@ -69,33 +123,29 @@ const u8 Camera_ConfigDescriptor[] =
     0x01,                                 /* bInterfaceSubClass : SC_VIDEOCONTROL */
     0x00,                                 /* bInterfaceProtocol : PC_PROTOCOL_UNDEFINED */
     0x02,                                 /* iInterface */
-    /* 09 bytes, total size 26*/
 
     /* 2.1. Class-specific VideoControl Interface Descriptor */
-    0x0d,                                 /* bLength */
+    VC_HEADER_DESC_SIZE(1),               /* bLength */
     0x24,                                 /* bDescriptorType : CS_INTERFACE */
     0x01,                                 /* bDescriptorSubType : VC_HEADER subtype */
     0x00,                                 /* bcdUVC : Revision of class specification that this device is based upon. For this example, the device complies with Video Class specification version 1.0 */
     0x01,
-    0x1e,                                 /* wTotalLength : Total size of class-specific descriptors*/
-    0x00,
-    0x80, 0x8d, 0x5b, 0x00,               /* dwClockFrequency : 0x005b8d80 -> 6,000,000 == 6MHz*/
+    MAKE_WORD(VC_CS_TOTAL_SIZE),          /* wTotalLength : Total size of class-specific descriptors*/
+    MAKE_DWORD(UVC_CLOCK_FREQ),           /* dwClockFrequency : PTS/SCR source clock, the core cycle counter */
     0x01,                                 /* bInCollection : Number of streaming interfaces. */
     0x01,                                 /* baInterfaceNr(1) : VideoStreaming interface 1 belongs to this VideoControl interface.*/
-    /* 13 Bytes, totoal size 39 */
 
     /* 2.2. Video Input Terminal Descriptor (Composite) */
-    0x08,                                 /* bLength */
+    VC_INPUT_TERMINAL_DESC_SIZE,          /* bLength */
     0x24,                                 /* bDescriptorType : CS_INTERFACE */
     0x02,                                 /* bDescriptorSubType : VC_INPUT_TERMINAL subtype */
     0x02,                                 /* bTerminalID: ID of this input terminal */
     0x01, 0x04,                           /* wTerminalType: 0x0401 COMPOSITE_CONNECTOR type. This terminal is the composite connector. */
     0x00,                                 /* bAssocTerminal: No association */
     0x00,                                 /* iTerminal: Unused*/
-    /* 8 Bytes, totoal size 47 */
 
     /* 2.3. Video Output Terminal Descriptor */
-    0x09,                                 /* bLength */
+    VC_OUTPUT_TERMINAL_DESC_SIZE,         /* bLength */
     0x24,                                 /* bDescriptorType : CS_INTERFACE */
     0x03,                                 /* bDescriptorSubType : VC_OUTPUT_TERMINAL subtype */
     0x03,                                 /* bTerminalID: ID of this output terminal */
@@ -103,89 +153,244 @@ const u8 Camera_ConfigDescriptor[] =
     0x00,                                 /* bAssocTerminal: No association */
     0x02,                                 /* bSourceID: The input pin of this unit is connected to the output pin of unit 2. */
     0x00,                                 /* iTerminal: Unused*/
-    /* 9 bytes, total size 56 */
 
     /* 3. Standard VideoStream Interface Descriptor*/
-    0x09,                                 /* bLength */
+    USB_INTERFACE_DESC_SIZE,              /* bLength */
     0x04,                                 /* bDescriptorType : INTERFACE */
     0x01,                                 /* bInterfaceNumber */
     0x00,                                 /* bAlternateSetting */
+#if UVC_BULK_MODE
+    0x01,                                 /* bNumEndpoints : bulk video data endpoint */
+#else
     0x00,                                 /* bNumEndpoints : 0 endpoints C no bandwidth used*/
+#endif
     0x0e,                                 /* bInterfaceClass : CC_VIDEO */
     0x02,                                 /* bInterfaceSubClass : SC_VIDEOSTREAMING */
     0x00,                                 /* bInterfaceProtocol : PC_PROTOCOL_UNDEFINED */
     0x00,                                 /* iInterface : unused */
-    /* 9 bytes, total size 65 */
 
     /* 3.1 Class-specific VideoStream Header Descriptor (Input) */
-    0x0e,                                 /* bLength */
+    VS_INPUT_HEADER_DESC_SIZE(VS_NUM_FORMATS),  /* bLength */
     0x24,                                 /* bDescriptorType : CS_INTERFACE */
     0x01,                                 /* bDescriptorSubType : VC_HEADER subtype */
-    0x01,                                 /* bNumFormats : One format descriptor follows. */
-    0x3f, 0x00,                           /* wTotalLength : Total size of class-specific descriptors*/
+    VS_NUM_FORMATS,                       /* bNumFormats : MJPEG and YUY2 format descriptors follow. */
+    MAKE_WORD(VS_CS_TOTAL_SIZE),          /* wTotalLength : Total size of class-specific descriptors*/
     0x81,                                 /* bEndpointAddress : 0x81 */
     0x00,                                 /* bmInfo : No dynamic format change supported. */
     0x03,                                 /* bTerminalLink : This VideoStreaming interface supplies terminal ID 3 (Output Terminal). */
-    0x00,                                 /* bStillCaptureMethod : Device supports still image capture method 0. */
+    0x02,                                 /* bStillCaptureMethod : Device supports still image capture method 2. */
     0x00,                                 /* bTriggerSupport : Hardware trigger supported for still image capture */
     0x00,                                 /* bTriggerUsage : Hardware trigger should initiate a still image capture. */
     0x01,                                 /* bControlSize : Size of the bmaControls field */
-    0x00,                                 /* bmaControls : No VideoStreaming specific controls are supported.*/
-    /* 14 Bytes, totoal size 79 */
+    0x00,                                 /* bmaControls(1) : No VideoStreaming specific controls are supported.*/
+    0x00,                                 /* bmaControls(2) */
 
     /* 3.2 Class-specific VideoStream Format(MJPEG) Descriptor */
-    0x0b,                                 /* bLength */
+    VS_FORMAT_MJPEG_DESC_SIZE,            /* bLength */
     0x24,                                 /* bDescriptorType : CS_INTERFACE */
     0x06,                                 /* bDescriptorSubType : VS_FORMAT_MJPEG subtype */
-    0x01,                                 /* bFormatIndex : First (and only) format descriptor */
-    0x01,                                 /* bNumFrameDescriptors : One frame descriptor for this format follows. */
+    VS_FORMAT_MJPEG,                      /* bFormatIndex : First format descriptor */
+    VS_NUM_FRAMES,                        /* bNumFrameDescriptors : One per VS_MJPEG_FRAME_LIST entry. */
     0x01,                                 /* bmFlags : Uses fixed size samples.. */
-    0x01,                                 /* bDefaultFrameIndex : Default frame index is 1. */
+    VS_DEF_FRAME,                         /* bDefaultFrameIndex : Default frame index is 2, 320x240. */
     0x00,                                 /* bAspectRatioX : Non-interlaced stream C not required. */
     0x00,                                 /* bAspectRatioY : Non-interlaced stream C not required. */
     0x00,                                 /* bmInterlaceFlags : Non-interlaced stream */
     0x00,                                 /* bCopyProtect : No restrictions imposed on the duplication of this video stream. */
-    /* 11 bytes, total size 90 */
 
-    /* 3.3 Class-specific VideoStream Frame Descriptor */
-    0x26,                                 /* bLength */
+    /* 3.3 Class-specific VideoStream Frame Descriptors, one per VS_MJPEG_FRAME_LIST entry */
+    VS_MJPEG_FRAME_LIST(UVC_MJPEG_FRAME_DESC)
+
+    /* 3.4 Class-specific Still Image Frame Descriptor */
+    VS_STILL_FRAME_DESC_SIZE(VS_STILL_NUM_SIZES),   /* bLength */
     0x24,                                 /* bDescriptorType : CS_INTERFACE */
-    0x07,                                 /* bDescriptorSubType : VS_FRAME_MJPEG */
-    0x01,                                 /* bFrameIndex : First (and only) frame descriptor */
-    0x02,                                 /* bmCapabilities : Still images using capture method 0 are supported at this frame setting.D1: Fixed frame-rate. */
-    MAKE_WORD(ImageWidth),     /* wWidth : Width of frame, pixels. */
-    MAKE_WORD(ImageHeight),    /* wHeight : Height of frame, pixels. */
-    MAKE_DWORD(MIN_BIT_RATE),             /* dwMinBitRate : Min bit rate in bits/s  */
-    MAKE_DWORD(MAX_BIT_RATE),             /* dwMaxBitRate : Max bit rate in bits/s  */
-    MAKE_DWORD(MAX_FRAME_SIZE),           /* dwMaxVideoFrameBufSize : Maximum video or still frame size, in bytes. */
-    MAKE_DWORD(FRAME_INTERVEL),           /* dwDefaultFrame Interval time, unit=100ns */
-    0x00,                                 /* bFrameIntervalType : Continuous frame interval */
-    MAKE_DWORD(FRAME_INTERVEL),           /* dwDefaultFrame Interval time, unit=100ns */
-    MAKE_DWORD(FRAME_INTERVEL),           /* dwDefaultFrame Interval time, unit=100ns */
-    0x00, 0x00, 0x00, 0x00,               /* dwFrameIntervalStep : No frame interval step supported. */
-    /* 38 bytes, total size 128 */
-
-    /* 4. Operational Alternate Setting 1 */
-    /* 4.1 Standard VideoStream Interface Descriptor */
-    0x09,                               /* Size of this descriptor, in bytes. */
-    0x04,                               /* INTERFACE descriptor type */
-    0x01,                               /* Index of this interface */
-    0x01,                               /* Index of this alternate setting */
-    0x01,                               /* endpoints, 0 C no bandwidth used */
-    0x0e,                               /* CC_VIDEO */
-    0x02,                               /* SC_VIDEOSTREAMING */
-    0x00,                               /* PC_PROTOCOL_UNDEFINED */
-    0x00,                               /* Unused */
-    /* 9 bytes, total size 137 */
-
-    /* 4.2 Standard VideoStream Isochronous Video Data Endpoint Descriptor */
-    0x07,                               /* Size of this descriptor, in bytes. */
+    0x03,                                 /* bDescriptorSubType : VS_STILL_IMAGE_FRAME */
+    0x00,                                 /* bEndpointAddress : method 2, stills use the video endpoint */
+    VS_STILL_NUM_SIZES,                   /* bNumImageSizePatterns */
+    MAKE_WORD(VS_STILL_WIDTH),            /* wWidth(1) */
+    MAKE_WORD(VS_STILL_HEIGHT),           /* wHeight(1) */
+    0x00,                                 /* bNumCompressionPattern */
+
+    /* 3.5 Class-specific VideoStream Format(Uncompressed) Descriptor */
+    VS_FORMAT_UNCOMPRESSED_DESC_SIZE,     /* bLength */
+    0x24,                                 /* bDescriptorType : CS_INTERFACE */
+    0x04,                                 /* bDescriptorSubType : VS_FORMAT_UNCOMPRESSED subtype */
+    VS_FORMAT_YUY2,                       /* bFormatIndex : Second format descriptor */
+    VS_YUY2_NUM_FRAMES,                   /* bNumFrameDescriptors : One per VS_YUY2_FRAME_LIST entry. */
+    0x59, 0x55, 0x59, 0x32,               /* guidFormat : YUY2 {32595559-0000-0010-8000-00AA00389B71} */
+    0x00, 0x00,
+    0x10, 0x00,
+    0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71,
+    0x10,                                 /* bBitsPerPixel : 16 for YUY2 */
+    0x01,                                 /* bDefaultFrameIndex : Default frame index is 1, 160x120. */
+    0x00,                                 /* bAspectRatioX : Non-interlaced stream C not required. */
+    0x00,                                 /* bAspectRatioY : Non-interlaced stream C not required. */
+    0x00,                                 /* bmInterlaceFlags : Non-interlaced stream */
+    0x00,                                 /* bCopyProtect : No restrictions imposed on the duplication of this video stream. */
+
+    /* 3.6 Class-specific VideoStream Uncompressed Frame Descriptors, one per VS_YUY2_FRAME_LIST entry */
+    VS_YUY2_FRAME_LIST(UVC_YUY2_FRAME_DESC)
+
+#if UVC_BULK_MODE
+    /* 3.7 Standard VideoStream Bulk Video Data Endpoint Descriptor */
+    USB_ENDPOINT_DESC_SIZE,             /* Size of this descriptor, in bytes. */
     0x05,                               /* ENDPOINT */
     0x81,                               /* IN endpoint 1 */
-    0x05,                               /* Isochronous transfer type. Asynchronous synchronization type. */
-    MAKE_WORD(PACKET_SIZE),             /* Max packet size, in bytes */
-    0x01,                               /* One frame interval */
-    /* 7 bytes, total size 144 */
+    0x02,                               /* Bulk transfer type */
+    MAKE_WORD(VS_BULK_PACKET_SIZE),     /* Max packet size, in bytes */
+    0x00,                               /* Ignored for bulk */
+#else
+    /* 4. Operational Alternate Settings, one per VS_ALT_LIST entry */
+    VS_ALT_LIST(UVC_ALT_SETTING_DESC)
+#endif
+
+#if UAC_MIC_ENABLE
+    /* 5. Standard Audio Interface Collection IAD */
+    USB_IAD_DESC_SIZE,                    /* bLength */
+    USB_ASSOCIATION_DESCRIPTOR_TYPE,      /* bDescriptorType */
+    UAC_AC_INTERFACE,                     /* bFirstInterface : AudioControl interface */
+    0x02,                                 /* bInterfaceCount : AudioControl and AudioStreaming */
+    0x01,                                 /* bFunctionClass : AUDIO */
+    0x00,                                 /* bFunctionSubClass : undefined for audio 1.0 */
+    0x00,                                 /* bFunctionProtocol : undefined for audio 1.0 */
+    0x00,                                 /* iFunction */
+
+    /* 6. Standard AudioControl Interface Descriptor */
+    USB_INTERFACE_DESC_SIZE,              /* bLength */
+    USB_INTERFACE_DESCRIPTOR_TYPE,        /* bDescriptorType */
+    UAC_AC_INTERFACE,                     /* bInterfaceNumber */
+    0x00,                                 /* bAlternateSetting */
+    0x00,                                 /* bNumEndpoints */
+    0x01,                                 /* bInterfaceClass : AUDIO */
+    0x01,                                 /* bInterfaceSubClass : AUDIOCONTROL */
+    0x00,                                 /* bInterfaceProtocol */
+    0x00,                                 /* iInterface */
+
+    /* 6.1 Class-specific AudioControl Interface Header Descriptor */
+    AC_HEADER_DESC_SIZE(1),               /* bLength */
+    0x24,                                 /* bDescriptorType : CS_INTERFACE */
+    0x01,                                 /* bDescriptorSubtype : HEADER */
+    0x00,                                 /* bcdADC : 1.00 */
+    0x01,
+    MAKE_WORD(AC_CS_TOTAL_SIZE),          /* wTotalLength */
+    0x01,                                 /* bInCollection : one AudioStreaming interface */
+    UAC_AS_INTERFACE,                     /* baInterfaceNr(1) */
+
+    /* 6.2 Microphone Input Terminal Descriptor */
+    AC_INPUT_TERMINAL_DESC_SIZE,          /* bLength */
+    0x24,                                 /* bDescriptorType : CS_INTERFACE */
+    0x02,                                 /* bDescriptorSubtype : INPUT_TERMINAL */
+    UAC_INPUT_TERMINAL_ID,                /* bTerminalID */
+    MAKE_WORD(0x0201),                    /* wTerminalType : Microphone */
+    0x00,                                 /* bAssocTerminal */
+    0x01,                                 /* bNrChannels : mono */
+    MAKE_WORD(0x0000),                    /* wChannelConfig : mono, no spatial location */
+    0x00,                                 /* iChannelNames */
+    0x00,                                 /* iTerminal */
+
+    /* 6.3 Feature Unit Descriptor, master mute and volume */
+    AC_FEATURE_UNIT_DESC_SIZE(1),         /* bLength */
+    0x24,                                 /* bDescriptorType : CS_INTERFACE */
+    0x06,                                 /* bDescriptorSubtype : FEATURE_UNIT */
+    UAC_FEATURE_UNIT_ID,                  /* bUnitID */
+    UAC_INPUT_TERMINAL_ID,                /* bSourceID */
+    0x01,                                 /* bControlSize */
+    0x03,                                 /* bmaControls(0) : Mute, Volume */
+    0x00,                                 /* bmaControls(1) : none per channel */
+    0x00,                                 /* iFeature */
+
+    /* 6.4 USB Streaming Output Terminal Descriptor */
+    AC_OUTPUT_TERMINAL_DESC_SIZE,         /* bLength */
+    0x24,                                 /* bDescriptorType : CS_INTERFACE */
+    0x03,                                 /* bDescriptorSubtype : OUTPUT_TERMINAL */
+    UAC_OUTPUT_TERMINAL_ID,               /* bTerminalID */
+    MAKE_WORD(0x0101),                    /* wTerminalType : USB streaming */
+    0x00,                                 /* bAssocTerminal */
+    UAC_FEATURE_UNIT_ID,                  /* bSourceID */
+    0x00,                                 /* iTerminal */
+
+    /* 7. Standard AudioStreaming Interface Descriptor, zero bandwidth */
+    USB_INTERFACE_DESC_SIZE,              /* bLength */
+    USB_INTERFACE_DESCRIPTOR_TYPE,        /* bDescriptorType */
+    UAC_AS_INTERFACE,                     /* bInterfaceNumber */
+    0x00,                                 /* bAlternateSetting */
+    0x00,                                 /* bNumEndpoints */
+    0x01,                                 /* bInterfaceClass : AUDIO */
+    0x02,                                 /* bInterfaceSubClass : AUDIOSTREAMING */
+    0x00,                                 /* bInterfaceProtocol */
+    0x00,                                 /* iInterface */
+
+    /* 8. Standard AudioStreaming Interface Descriptor, operational */
+    USB_INTERFACE_DESC_SIZE,              /* bLength */
+    USB_INTERFACE_DESCRIPTOR_TYPE,        /* bDescriptorType */
+    UAC_AS_INTERFACE,                     /* bInterfaceNumber */
+    0x01,                                 /* bAlternateSetting */
+    0x01,                                 /* bNumEndpoints */
+    0x01,                                 /* bInterfaceClass : AUDIO */
+    0x02,                                 /* bInterfaceSubClass : AUDIOSTREAMING */
+    0x00,                                 /* bInterfaceProtocol */
+    0x00,                                 /* iInterface */
+
+    /* 8.1 Class-specific AudioStreaming General Descriptor */
+    AS_GENERAL_DESC_SIZE,                 /* bLength */
+    0x24,                                 /* bDescriptorType : CS_INTERFACE */
+    0x01,                                 /* bDescriptorSubtype : AS_GENERAL */
+    UAC_OUTPUT_TERMINAL_ID,               /* bTerminalLink */
+    0x01,                                 /* bDelay : one frame */
+    MAKE_WORD(0x0001),                    /* wFormatTag : PCM */
+
+    /* 8.2 Type I Format Type Descriptor */
+    AS_FORMAT_TYPE_I_DESC_SIZE(1),        /* bLength */
+    0x24,                                 /* bDescriptorType : CS_INTERFACE */
+    0x02,                                 /* bDescriptorSubtype : FORMAT_TYPE */
+    0x01,                                 /* bFormatType : FORMAT_TYPE_I */
+    0x01,                                 /* bNrChannels */
+    UAC_SAMPLE_BYTES,                     /* bSubFrameSize */
+    UAC_SAMPLE_BYTES*8,                   /* bBitResolution */
+    0x01,                                 /* bSamFreqType : one discrete rate */
+    (u8)UAC_SAMPLE_RATE,                  /* tSamFreq */
+    (u8)(UAC_SAMPLE_RATE >> 8),
+    (u8)(UAC_SAMPLE_RATE >> 16),
+
+    /* 8.3 Standard AudioStreaming Isochronous Audio Data Endpoint Descriptor */
+    AS_ENDPOINT_DESC_SIZE,                /* bLength */
+    USB_ENDPOINT_DESCRIPTOR_TYPE,         /* bDescriptorType */
+    0x82,                                 /* bEndpointAddress : IN endpoint 2 */
+    0x05,                                 /* bmAttributes : isochronous, asynchronous */
+    MAKE_WORD(UAC_PACKET_SIZE_MAX),       /* wMaxPacketSize */
+    0x01,                                 /* bInterval : every frame */
+    0x00,                                 /* bRefresh */
+    0x00,                                 /* bSynchAddress */
+
+    /* 8.4 Class-specific Isochronous Audio Data Endpoint Descriptor */
+    AS_CS_ENDPOINT_DESC_SIZE,             /* bLength */
+    0x25,                                 /* bDescriptorType : CS_ENDPOINT */
+    0x01,                                 /* bDescriptorSubtype : EP_GENERAL */
+    0x00,                                 /* bmAttributes : no sampling frequency control */
+    0x00,                                 /* bLockDelayUnits */
+    MAKE_WORD(0x0000),                    /* wLockDelay */
+#endif
+  };
+
+/* the initializer above must come out at the length usb_desc.h computes */
+typedef char Camera_ConfigDescriptor_SizeCheck[(sizeof(Camera_ConfigDescriptor) == CAMERA_SIZ_CONFIG_DESC) ? 1 : -1];
+
+/* Frame sizes of the VS_FRAME_MJPEG descriptors, by bFrameIndex-1 */
+const UVC_FrameType UVC_Frames[VS_NUM_FRAMES] =
+  {
+    VS_MJPEG_FRAME_LIST(UVC_FRAME_ENTRY)
+  };
+
+/* Frame sizes of the VS_FRAME_UNCOMPRESSED descriptors, by bFrameIndex-1 */
+const UVC_FrameType UVC_YuvFrames[VS_YUY2_NUM_FRAMES] =
+  {
+    VS_YUY2_FRAME_LIST(UVC_FRAME_ENTRY)
+  };
+
+/* Supported dwFrameInterval values, 100ns units, shortest first */
+const u32 UVC_Intervals[VS_NUM_INTERVALS] =
+  {
+    VS_MJPEG_INTERVAL_LIST(UVC_INTERVAL_ENTRY)
   };
 
 /* USB String Descriptors */
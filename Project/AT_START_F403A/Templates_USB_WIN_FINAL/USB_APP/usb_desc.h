@@ -20,6 +20,14 @@
 /* Includes ------------------------------------------------------------------*/
 
 /* Exported types ------------------------------------------------------------*/
+//one VS_FRAME descriptor, used by probe/commit negotiation and the sensor setup
+typedef struct
+{
+  u16 wWidth;
+  u16 wHeight;
+  u32 dwMaxVideoFrameSize;
+} UVC_FrameType;
+
 /* Exported constants --------------------------------------------------------*/
 /* Exported macro ------------------------------------------------------------*/
 #define   UNCOMPRESS        0
@@ -37,18 +45,234 @@
 
 #define USB_ASSOCIATION_DESCRIPTOR_TYPE         0x0B
 
-#define IMG_MJPG_FRAMERATE      10           //ԤMJPEGƵ֡
+#define IMG_MJPG_FRAMERATE      15           //ԤMJPEGƵ֡, ߵ
+
+//1: stream over a bulk endpoint (UVC 1.1 bulk, one payload header per frame transfer)
+//0: stream over isochronous alternate settings
+#define UVC_BULK_MODE                           0
+
+//1: when no new frame is queued at the end of the interval, send the last one again
+//0: wait for a new frame, header-only packets (or NAKs in bulk mode) in between
+#define UVC_REPEAT_FRAME                        0
+
+//1: composite camera + microphone, a UAC 1.0 function on interfaces 2/3 with EP2 (WM8988 ADC)
+//   needs the WM8988 wired to I2S3 (PA15/PB3/PB5, JTAG off, see mic.h), and EP2 takes the
+//   312 byte video alternate so YUY2 falls to about 3 fps
+//0: camera only
+#define UAC_MIC_ENABLE                          0
+
+//VideoStreaming isochronous alternate settings, EP1 max packet size of each
+//EP1 is ping-pong buffered, the largest one fills the 768 byte PMA (Set_USB768ByteMode)
+//with the microphone on, EP2 takes the room of the largest one
+#define VS_PACKET_SIZE_ALT1                     0xB0        //176
+#define VS_PACKET_SIZE_ALT2                     0x100       //256
+#define VS_PACKET_SIZE_ALT3                     0x138       //312
+#define VS_BULK_PACKET_SIZE                     0x40        //64, full speed bulk
+#if UVC_BULK_MODE
+#define VS_PACKET_SIZE_MAX                      VS_BULK_PACKET_SIZE
+#define VS_PACKET_SIZE_DEF                      VS_BULK_PACKET_SIZE
+#elif UAC_MIC_ENABLE
+#define VS_PACKET_SIZE_MAX                      VS_PACKET_SIZE_ALT2
+#define VS_PACKET_SIZE_DEF                      VS_PACKET_SIZE_ALT1
+#else
+#define VS_PACKET_SIZE_MAX                      VS_PACKET_SIZE_ALT3
+#define VS_PACKET_SIZE_DEF                      VS_PACKET_SIZE_ALT1
+#endif
+#define MIN_BIT_RATE(size)                  ((size)/4*8*IMG_MJPG_FRAMERATE)
+#define MAX_BIT_RATE(size)                  ((size)*8*IMG_MJPG_FRAMERATE)
+
+//MJPEG frame sizes, bFrameIndex 1..4, smallest first
+//FRAMEn_SIZE is the largest JPEG expected at that size (dwMaxVideoFrameBufSize), and
+//also the room the frame arena keeps free for each capture. DVP DMA can not move more
+//than DVP_DMA_MAX_LEN in one frame, which caps SVGA.
+#define VS_FRAME1_WIDTH                         160
+#define VS_FRAME1_HEIGHT                        120
+#define VS_FRAME1_SIZE                          (8*1024)
+#define VS_FRAME2_WIDTH                         320
+#define VS_FRAME2_HEIGHT                        240
+#define VS_FRAME2_SIZE                          (20*1024)
+#define VS_FRAME3_WIDTH                         640
+#define VS_FRAME3_HEIGHT                        480
+#define VS_FRAME3_SIZE                          (48*1024)
+#define VS_FRAME4_WIDTH                         800
+#define VS_FRAME4_HEIGHT                        600
+#define VS_FRAME4_SIZE                          (63*1024)
+
+//still image, capture method 2: sent on the video endpoint with the STI header bit
+//largest 4:3 size whose JPEG stays inside one DVP DMA block, needs the extended SRAM
+#define VS_STILL_WIDTH                          1024
+#define VS_STILL_HEIGHT                         768
+#define VS_STILL_SIZE                           (63*1024)
 
-#define PACKET_SIZE                             0xB0        //176
-#define MIN_BIT_RATE                        (20*1024*IMG_MJPG_FRAMERATE)
-#define MAX_BIT_RATE                        (80*1024*IMG_MJPG_FRAMERATE)
+//uncompressed YUY2 frame sizes, bFrameIndex 1..2 of the second format
+//no frame is ever held whole, lines go from the sensor to EP1 through a small FIFO
+#define VS_YUY2_FRAME1_WIDTH                    160
+#define VS_YUY2_FRAME1_HEIGHT                   120
+#define VS_YUY2_FRAME1_SIZE                     (VS_YUY2_FRAME1_WIDTH*VS_YUY2_FRAME1_HEIGHT*2)
+#define VS_YUY2_FRAME2_WIDTH                    176
+#define VS_YUY2_FRAME2_HEIGHT                   144
+#define VS_YUY2_FRAME2_SIZE                     (VS_YUY2_FRAME2_WIDTH*VS_YUY2_FRAME2_HEIGHT*2)
+#define VS_YUY2_LINE_MAX                        (VS_YUY2_FRAME2_WIDTH*2)    //bytes in the widest line
+#define YUY2_BIT_RATE(size, interval)           ((size)*8*(10000000ul/(interval)))
 
-#define MAX_FRAME_SIZE          (40*1024*2)      //ÿ֡JPEG ByteӦHostҪBuffer Size
+#define MAX_FRAME_SIZE          VS_FRAME4_SIZE   //ÿ֡JPEG ByteӦHostҪBuffer Size
 
 #define FRAME_INTERVEL          (10000000ul/IMG_MJPG_FRAMERATE)     //֡ʱ䣬λ100ns
 
-#define CAMERA_SIZ_CONFIG_DESC                  144         //!!
+//discrete dwFrameInterval values, 100ns units, shortest first
+//UXGA sensor timing runs 15fps at CLKRC 0, every row only divides the sensor clock
+#define VS_INTERVAL1                            FRAME_INTERVEL  //15fps
+#define VS_INTERVAL2                            1333333         //7.5fps
+#define VS_INTERVAL3                            2000000         //5fps
+#define VS_INTERVAL4                            3333333         //3fps
+//YUY2 only gets the intervals whose line rate the 300 byte isochronous payload keeps up with,
+//244 bytes with the microphone on
+#if UAC_MIC_ENABLE
+#define VS_YUY2_FIRST_INTERVAL                  3           //UVC_Intervals[] index of VS_INTERVAL4
+#else
+#define VS_YUY2_FIRST_INTERVAL                  2           //UVC_Intervals[] index of VS_INTERVAL3
+#endif
+
+//Tables the descriptors are built from. Camera_ConfigDescriptor, its lengths and the
+//negotiation tables (UVC_Frames[], UVC_YuvFrames[], UVC_Intervals[]) are all generated
+//from these lists, add a frame size or an alternate setting here and nowhere else.
+//MJPEG frames, X(bFrameIndex, width, height, largest JPEG), smallest first
+#define VS_MJPEG_FRAME_LIST(X) \
+    X(1, VS_FRAME1_WIDTH, VS_FRAME1_HEIGHT, VS_FRAME1_SIZE) \
+    X(2, VS_FRAME2_WIDTH, VS_FRAME2_HEIGHT, VS_FRAME2_SIZE) \
+    X(3, VS_FRAME3_WIDTH, VS_FRAME3_HEIGHT, VS_FRAME3_SIZE) \
+    X(4, VS_FRAME4_WIDTH, VS_FRAME4_HEIGHT, VS_FRAME4_SIZE)
+//YUY2 frames, X(bFrameIndex, width, height, frame size)
+#define VS_YUY2_FRAME_LIST(X) \
+    X(1, VS_YUY2_FRAME1_WIDTH, VS_YUY2_FRAME1_HEIGHT, VS_YUY2_FRAME1_SIZE) \
+    X(2, VS_YUY2_FRAME2_WIDTH, VS_YUY2_FRAME2_HEIGHT, VS_YUY2_FRAME2_SIZE)
+//dwFrameInterval of every MJPEG frame, X(interval), shortest first
+#define VS_MJPEG_INTERVAL_LIST(X) \
+    X(VS_INTERVAL1) \
+    X(VS_INTERVAL2) \
+    X(VS_INTERVAL3) \
+    X(VS_INTERVAL4)
+//dwFrameInterval of every YUY2 frame, the tail of VS_MJPEG_INTERVAL_LIST from VS_YUY2_FIRST_INTERVAL
+#if UAC_MIC_ENABLE
+#define VS_YUY2_INTERVAL_MIN                    VS_INTERVAL4    //fastest, also the default
+#define VS_YUY2_INTERVAL_MAX                    VS_INTERVAL4
+#define VS_YUY2_INTERVAL_LIST(X) \
+    X(VS_YUY2_INTERVAL_MIN)
+#else
+#define VS_YUY2_INTERVAL_MIN                    VS_INTERVAL3    //fastest, also the default
+#define VS_YUY2_INTERVAL_MAX                    VS_INTERVAL4
+#define VS_YUY2_INTERVAL_LIST(X) \
+    X(VS_YUY2_INTERVAL_MIN) \
+    X(VS_YUY2_INTERVAL_MAX)
+#endif
+//isochronous alternate settings of the VideoStreaming interface, X(bAlternateSetting, EP1 max packet size)
+#if UAC_MIC_ENABLE
+#define VS_ALT_LIST(X) \
+    X(1, VS_PACKET_SIZE_ALT1) \
+    X(2, VS_PACKET_SIZE_ALT2)
+#else
+#define VS_ALT_LIST(X) \
+    X(1, VS_PACKET_SIZE_ALT1) \
+    X(2, VS_PACKET_SIZE_ALT2) \
+    X(3, VS_PACKET_SIZE_ALT3)
+#endif
+
+//microphone function, 16 bit mono PCM at one fixed rate
+//the WM8988 is I2S master on its own 12MHz MCLK, so the rate is not locked to SOF:
+//packets carry one sample more or less now and then (asynchronous endpoint)
+#define UAC_SAMPLE_RATE                         16000
+#define UAC_SAMPLE_BYTES                        2
+#define UAC_PACKET_SAMPLES                      (UAC_SAMPLE_RATE/1000)
+#define UAC_PACKET_SIZE_MAX                     ((UAC_PACKET_SAMPLES+1)*UAC_SAMPLE_BYTES)   //EP2, 34
+#define UAC_AC_INTERFACE                        2           //AudioControl
+#define UAC_AS_INTERFACE                        3           //AudioStreaming
+#define UAC_INPUT_TERMINAL_ID                   1
+#define UAC_FEATURE_UNIT_ID                     2
+#define UAC_OUTPUT_TERMINAL_ID                  3
+//feature unit volume range, 1/256 dB, the WM8988 ADC digital volume has 0.5dB steps
+#define UAC_VOLUME_MIN                          ((s16)0xD000)       //-48dB
+#define UAC_VOLUME_MAX                          ((s16)0x1800)       //+24dB
+#define UAC_VOLUME_RES                          ((s16)0x0080)       //0.5dB
+
+#define UVC_COUNT_1(a)                          +1
+#define UVC_COUNT_2(a, b)                       +1
+#define UVC_COUNT_4(a, b, c, d)                 +1
+
+//formats, frames and intervals the negotiation accepts
+#define VS_FORMAT_MJPEG                         1
+#define VS_FORMAT_YUY2                          2
+#define VS_NUM_FORMATS                          2
+#define VS_NUM_FRAMES                           (0 VS_MJPEG_FRAME_LIST(UVC_COUNT_4))
+#define VS_YUY2_NUM_FRAMES                      (0 VS_YUY2_FRAME_LIST(UVC_COUNT_4))
+#define VS_DEF_FRAME                            2           //320x240, the size OV2640_Init() starts with
+#define VS_NUM_INTERVALS                        (0 VS_MJPEG_INTERVAL_LIST(UVC_COUNT_1))    //UVC_Intervals[], shortest first
+#define VS_YUY2_NUM_INTERVALS                   (0 VS_YUY2_INTERVAL_LIST(UVC_COUNT_1))
+#define VS_ALT_NUM                              (0 VS_ALT_LIST(UVC_COUNT_2))
+#define VS_STILL_NUM_SIZES                      1
+
+#define CAMERA_SIZ_STREAMHD                     12          //UVC payload header with PTS and SCR
+#define UVC_CLOCK_FREQ                          192000000   //PTS/SCR source clock, DWT->CYCCNT at SYSCLK_FREQ_192MHz
+#if UVC_BULK_MODE
+#define VS_MAX_PAYLOAD_SIZE(size)               ((size)+CAMERA_SIZ_STREAMHD)    //a whole frame per transfer
+#else
+#define VS_MAX_PAYLOAD_SIZE(size)               VS_PACKET_SIZE_MAX
+#endif
+
+//descriptor lengths
+#define USB_CONFIG_DESC_SIZE                    9
+#define USB_IAD_DESC_SIZE                       8
+#define USB_INTERFACE_DESC_SIZE                 9
+#define USB_ENDPOINT_DESC_SIZE                  7
+#define VC_HEADER_DESC_SIZE(n)                  (12+(n))        //n VideoStreaming interfaces
+#define VC_INPUT_TERMINAL_DESC_SIZE             8
+#define VC_OUTPUT_TERMINAL_DESC_SIZE            9
+#define VS_INPUT_HEADER_DESC_SIZE(p)            (13+(p))        //p formats, one bmaControls byte each
+#define VS_FORMAT_MJPEG_DESC_SIZE               11
+#define VS_FORMAT_UNCOMPRESSED_DESC_SIZE        27
+#define VS_FRAME_DESC_SIZE(n)                   (26+4*(n))      //n discrete frame intervals
+#define VS_STILL_FRAME_DESC_SIZE(n)             (6+4*(n))       //n image sizes, no compression patterns
+#define AC_HEADER_DESC_SIZE(n)                  (8+(n))         //n AudioStreaming interfaces
+#define AC_INPUT_TERMINAL_DESC_SIZE             12
+#define AC_FEATURE_UNIT_DESC_SIZE(ch)           (7+(ch)+1)      //ch channels and the master, one byte controls
+#define AC_OUTPUT_TERMINAL_DESC_SIZE            9
+#define AS_GENERAL_DESC_SIZE                    7
+#define AS_FORMAT_TYPE_I_DESC_SIZE(n)           (8+3*(n))       //n discrete sample rates
+#define AS_ENDPOINT_DESC_SIZE                   9               //audio class adds bRefresh/bSynchAddress
+#define AS_CS_ENDPOINT_DESC_SIZE                7
+
+//wTotalLength of the class-specific VideoControl and VideoStreaming descriptors
+#define VC_CS_TOTAL_SIZE                        (VC_HEADER_DESC_SIZE(1) + VC_INPUT_TERMINAL_DESC_SIZE + \
+                                                 VC_OUTPUT_TERMINAL_DESC_SIZE)
+#define VS_CS_TOTAL_SIZE                        (VS_INPUT_HEADER_DESC_SIZE(VS_NUM_FORMATS) + \
+                                                 VS_FORMAT_MJPEG_DESC_SIZE + \
+                                                 VS_NUM_FRAMES*VS_FRAME_DESC_SIZE(VS_NUM_INTERVALS) + \
+                                                 VS_STILL_FRAME_DESC_SIZE(VS_STILL_NUM_SIZES) + \
+                                                 VS_FORMAT_UNCOMPRESSED_DESC_SIZE + \
+                                                 VS_YUY2_NUM_FRAMES*VS_FRAME_DESC_SIZE(VS_YUY2_NUM_INTERVALS))
+#if UVC_BULK_MODE
+#define VS_EP_TOTAL_SIZE                        USB_ENDPOINT_DESC_SIZE      //bulk endpoint in alternate setting 0
+#else
+#define VS_EP_TOTAL_SIZE                        (VS_ALT_NUM*(USB_INTERFACE_DESC_SIZE + USB_ENDPOINT_DESC_SIZE))
+#endif
+//wTotalLength of the class-specific AudioControl descriptors, and the whole audio function
+#define AC_CS_TOTAL_SIZE                        (AC_HEADER_DESC_SIZE(1) + AC_INPUT_TERMINAL_DESC_SIZE + \
+                                                 AC_FEATURE_UNIT_DESC_SIZE(1) + AC_OUTPUT_TERMINAL_DESC_SIZE)
+#if UAC_MIC_ENABLE
+#define UAC_TOTAL_SIZE                          (USB_IAD_DESC_SIZE + USB_INTERFACE_DESC_SIZE + AC_CS_TOTAL_SIZE + \
+                                                 2*USB_INTERFACE_DESC_SIZE + AS_GENERAL_DESC_SIZE + \
+                                                 AS_FORMAT_TYPE_I_DESC_SIZE(1) + AS_ENDPOINT_DESC_SIZE + \
+                                                 AS_CS_ENDPOINT_DESC_SIZE)
+#define CAMERA_NUM_INTERFACES                   4
+#else
+#define UAC_TOTAL_SIZE                          0
+#define CAMERA_NUM_INTERFACES                   2
+#endif
+#define CAMERA_SIZ_CONFIG_DESC                  (USB_CONFIG_DESC_SIZE + USB_IAD_DESC_SIZE + \
+                                                 USB_INTERFACE_DESC_SIZE + VC_CS_TOTAL_SIZE + \
+                                                 USB_INTERFACE_DESC_SIZE + VS_CS_TOTAL_SIZE + \
+                                                 VS_EP_TOTAL_SIZE + UAC_TOTAL_SIZE)
 
+#define CAMERA_EP0_PACKET_SIZE                  0x40        //bMaxPacketSize0
 #define CAMERA_SIZ_DEVICE_DESC                  18
 #define CAMERA_SIZ_STRING_LANGID                4
 #define CAMERA_SIZ_STRING_VENDOR                38
@@ -59,11 +283,14 @@
 
 /* Exported functions ------------------------------------------------------- */
 extern const u8 Camera_DeviceDescriptor[CAMERA_SIZ_DEVICE_DESC];
-extern const u8 Camera_ConfigDescriptor[CAMERA_SIZ_CONFIG_DESC];
+extern const u8 Camera_ConfigDescriptor[];     //CAMERA_SIZ_CONFIG_DESC bytes, checked in usb_desc.c
 extern const u8 Camera_StringLangID[CAMERA_SIZ_STRING_LANGID];
 extern const u8 Camera_StringVendor[CAMERA_SIZ_STRING_VENDOR];
 extern const u8 Camera_StringProduct[CAMERA_SIZ_STRING_PRODUCT];
 extern u8 Camera_StringSerial[CAMERA_SIZ_STRING_SERIAL];
+extern const UVC_FrameType UVC_Frames[VS_NUM_FRAMES];
+extern const UVC_FrameType UVC_YuvFrames[VS_YUY2_NUM_FRAMES];
+extern const u32 UVC_Intervals[VS_NUM_INTERVALS];
 
 #endif /* __USB_DESC_H */
 /******************* (C) COPYRIGHT 2008 STMicroelectronics *****END OF FILE****/
@@ -23,12 +23,12 @@
 #include "hw_config.h"
 #include "usb_istr.h"
 #include "uvcstream.h"
+#include "uacstream.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
-
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
@@ -45,6 +45,21 @@ void EP1_IN_Callback(void)
     UVC_SendPack_Irq();
 }
 
+#if UAC_MIC_ENABLE
+/*******************************************************************************
+* Function Name  : EP2_IN_Callback
+* Description    : Microphone packet sent, queue the next one.
+* Input          : None.
+* Output         : None.
+* Return         : None.
+*******************************************************************************/
+void EP2_IN_Callback(void)
+{
+    UAC_SendPack_Irq();
+}
+#endif
+
+
 
 /******************* (C) COPYRIGHT 2008 STMicroelectronics *****END OF FILE****/
 
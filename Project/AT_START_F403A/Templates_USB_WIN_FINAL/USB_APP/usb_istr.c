@@ -24,6 +24,7 @@
 #include "usb_prop.h"
 #include "usb_pwr.h"
 #include "usb_istr.h"
+#include "uvcstream.h"
 
 /** @addtogroup AT32F413_StdPeriph_Examples
   * @{
@@ -188,7 +189,7 @@ void USB_Istr(void)
 *******************************************************************************/
 void SOF_Callback(void)
 {
-
+  UVC_Stream_Sof();
 }
 
 /**
@@ -20,11 +20,15 @@
 #include "usb_desc.h"
 #include "usb_pwr.h"
 #include "hw_config.h"
+#include "uvcstream.h"
+#include "uacstream.h"
 
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
+#define MAKE_U32(a)         ((u32)(a)[0] | ((u32)(a)[1] << 8) | ((u32)(a)[2] << 16) | ((u32)(a)[3] << 24))
+#define SET_U32(a, v)       do { (a)[0] = (u8)(v); (a)[1] = (u8)((v) >> 8); (a)[2] = (u8)((v) >> 16); (a)[3] = (u8)((v) >> 24); } while (0)
 /* Private variables ---------------------------------------------------------*/
 typedef struct  _VideoControl
 {
@@ -51,16 +55,16 @@ VideoControl    videoCommitControl =
 {
     {0x01,0x00},                      // bmHint
     {0x01},                           // bFormatIndex
-    {0x01},                           // bFrameIndex
+    {VS_DEF_FRAME},                   // bFrameIndex
     {MAKE_DWORD(FRAME_INTERVEL)},          // dwFrameInterval
     {0x00,0x00,},                     // wKeyFrameRate
     {0x00,0x00,},                     // wPFrameRate
     {0x00,0x00,},                     // wCompQuality
     {0x00,0x00,},                     // wCompWindowSize
     {0x00,0x00},                      // wDelay
-    {MAKE_DWORD(MAX_FRAME_SIZE)},     // dwMaxVideoFrameSize
-    {0x00, 0x00, 0x00, 0x00},         // dwMaxPayloadTransferSize
-    {0x00, 0x00, 0x00, 0x00},         // dwClockFrequency
+    {MAKE_DWORD(VS_FRAME2_SIZE)},     // dwMaxVideoFrameSize
+    {MAKE_DWORD(VS_MAX_PAYLOAD_SIZE(VS_FRAME2_SIZE))}, // dwMaxPayloadTransferSize
+    {MAKE_DWORD(UVC_CLOCK_FREQ)},     // dwClockFrequency
     {0x00},                           // bmFramingInfo
     {0x00},                           // bPreferedVersion
     {0x00},                           // bMinVersion
@@ -71,22 +75,56 @@ VideoControl    videoProbeControl =
 {
     {0x01,0x00},                      // bmHint
     {0x01},                           // bFormatIndex
-    {0x01},                           // bFrameIndex
+    {VS_DEF_FRAME},                   // bFrameIndex
     {MAKE_DWORD(FRAME_INTERVEL)},          // dwFrameInterval
     {0x00,0x00,},                     // wKeyFrameRate
     {0x00,0x00,},                     // wPFrameRate
     {0x00,0x00,},                     // wCompQuality
     {0x00,0x00,},                     // wCompWindowSize
     {0x00,0x00},                      // wDelay
-    {MAKE_DWORD(MAX_FRAME_SIZE)},    // dwMaxVideoFrameSize
-    {0x00, 0x00, 0x00, 0x00},         // dwMaxPayloadTransferSize
-    {0x00, 0x00, 0x00, 0x00},         // dwClockFrequency
+    {MAKE_DWORD(VS_FRAME2_SIZE)},    // dwMaxVideoFrameSize
+    {MAKE_DWORD(VS_MAX_PAYLOAD_SIZE(VS_FRAME2_SIZE))}, // dwMaxPayloadTransferSize
+    {MAKE_DWORD(UVC_CLOCK_FREQ)},     // dwClockFrequency
     {0x00},                           // bmFramingInfo
     {0x00},                           // bPreferedVersion
     {0x00},                           // bMinVersion
     {0x00},                           // bMaxVersion
 };
 
+typedef struct  _StillControl
+{
+    u8    bFormatIndex[1];                // 0x01
+    u8    bFrameIndex[1];                 // 0x02
+    u8    bCompressionIndex[1];           // 0x03
+    u8    dwMaxVideoFrameSize[4];         // 0x07
+    u8    dwMaxPayloadTransferSize[4];    // 0x0B
+}   StillControl;
+
+//VS_STILL_PROBE/COMMIT_CONTROL, one still size only, so every request gets this
+const StillControl stillDefControl =
+{
+    {VS_FORMAT_MJPEG},                // bFormatIndex
+    {0x01},                           // bFrameIndex : first still image size pattern
+    {0x00},                           // bCompressionIndex : no compression patterns
+    {MAKE_DWORD(VS_STILL_SIZE)},      // dwMaxVideoFrameSize
+    {MAKE_DWORD(VS_MAX_PAYLOAD_SIZE(VS_STILL_SIZE))}, // dwMaxPayloadTransferSize
+};
+
+VideoControl    videoScratchControl;          //GET_MIN/GET_MAX/GET_DEF answer
+StillControl    stillProbeControl;
+StillControl    stillCommitControl;
+u8  videoControlLen[2] = {sizeof(VideoControl), 0x00};
+u8  stillControlLen[2] = {sizeof(StillControl), 0x00};
+u8  stillTriggerLen[2] = {0x01, 0x00};
+u8  videoControlInfo = 0x03;                  //supports GET and SET
+u8  videoStillTrigger = 0;                    //VS_STILL_IMAGE_TRIGGER_CONTROL, 1 until the still is sent
+u8  videoSetCurSelector = 0;                  //VS control selector written by the running SET_CUR
+#if UAC_MIC_ENABLE
+u8  audioControl[2];                          //feature unit GET answer / SET_CUR data, little endian
+u8  audioControlSize = 0;                     //bytes of audioControl in use, 1 for mute, 2 for volume
+u8  audioSetCurSelector = 0;                  //FU control selector written by the running SET_CUR
+#endif
+
 /* -------------------------------------------------------------------------- */
 /*  Structures initializations */
 /* -------------------------------------------------------------------------- */
@@ -110,7 +148,7 @@ DEVICE_PROP Device_Property =
     UsbCamera_GetConfigDescriptor,
     UsbCamera_GetStringDescriptor,
     0,
-    0x40 /*MAX PACKET SIZE*/
+    CAMERA_EP0_PACKET_SIZE /*MAX PACKET SIZE*/
   };
 
 USER_STANDARD_REQUESTS User_Standard_Requests =
@@ -146,6 +184,13 @@ ONE_DESCRIPTOR String_Descriptor[4] =
 
 /* Extern variables ----------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
+static void Video_Control_Fill(VideoControl* ctl, u8 format, u8 frame, u32 interval);
+static void Video_Control_Clamp(VideoControl* ctl);
+static u8* Video_Control_Copy(u16 Length, u8* buf, u16 size);
+static RESULT Still_Data_Setup(u8 RequestNo, u8 selector);
+#if UAC_MIC_ENABLE
+static RESULT Audio_Data_Setup(u8 RequestNo);
+#endif
 /* Extern function prototypes ------------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 /*******************************************************************************
@@ -202,10 +247,14 @@ void UsbCamera_Reset(void)
     SetEPRxValid(ENDP0);
 
     /* Initialize Endpoint 1 */
+#if UVC_BULK_MODE
+    SetEPType(ENDP1, EP_BULK);
+#else
     SetEPType(ENDP1, EP_ISOCHRONOUS);
+#endif
     SetEPDoubleBuff(ENDP1);
     SetEPDblBuffAddr(ENDP1, ENDP1_BUF0Addr, ENDP1_BUF1Addr);
-    SetEPDblBuffCount(ENDP1, EP_DBUF_IN, PACKET_SIZE);
+    SetEPDblBuffCount(ENDP1, EP_DBUF_IN, VS_PACKET_SIZE_MAX);
     ClearDTOG_RX(ENDP1);
     ClearDTOG_TX(ENDP1);
     SetEPDblBuf0Count(ENDP1, EP_DBUF_IN, 0);
@@ -214,10 +263,28 @@ void UsbCamera_Reset(void)
 //    SetEPTxStatus(ENDP1, EP_TX_VALID);
     SetEPTxStatus(ENDP1, EP_TX_NAK);
 
+#if UAC_MIC_ENABLE
+    /* Initialize Endpoint 2, microphone */
+    SetEPType(ENDP2, EP_ISOCHRONOUS);
+    SetEPDoubleBuff(ENDP2);
+    SetEPDblBuffAddr(ENDP2, ENDP2_BUF0Addr, ENDP2_BUF1Addr);
+    ClearDTOG_RX(ENDP2);
+    ClearDTOG_TX(ENDP2);
+    SetEPDblBuf0Count(ENDP2, EP_DBUF_IN, 0);
+    SetEPDblBuf1Count(ENDP2, EP_DBUF_IN, 0);
+    SetEPRxStatus(ENDP2, EP_RX_DIS);
+    SetEPTxStatus(ENDP2, EP_TX_NAK);
+    UAC_Stream_Stop();
+#endif
+
     SetEPRxValid(ENDP0);
     /* Set this device to response on default address */
     SetDeviceAddress(0);
 
+    stillProbeControl = stillDefControl;
+    stillCommitControl = stillDefControl;
+    UVC_Stream_Stop();
+
     bDeviceState = ATTACHED;
 }
 
@@ -260,7 +327,53 @@ void UsbCamera_SetDeviceAddress (void)
 * Return         : None.
 *******************************************************************************/
 void UsbCamera_Status_In(void)
-{}
+{
+  //SET_CUR data has arrived, bring it into the supported range
+  if (videoSetCurSelector == 0x01)
+  {
+    Video_Control_Clamp(&videoProbeControl);
+  }
+  else if (videoSetCurSelector == 0x02)
+  {
+    Video_Control_Clamp(&videoCommitControl);
+    videoProbeControl = videoCommitControl;
+    UVC_Stream_Commit(videoCommitControl.bFormatIndex[0], videoCommitControl.bFrameIndex[0],
+                      MAKE_U32(videoCommitControl.dwFrameInterval));
+  }
+  else if ((videoSetCurSelector == VS_STILL_PROBE_CONTROL) || (videoSetCurSelector == VS_STILL_COMMIT_CONTROL))
+  {
+    stillProbeControl = stillDefControl;
+    stillCommitControl = stillDefControl;
+  }
+  else if (videoSetCurSelector == VS_STILL_IMAGE_TRIGGER_CONTROL)
+  {
+    if (videoStillTrigger == 0x01)      //1: transmit still image, others are method 3 only
+    {
+      UVC_Still_Trigger();
+    }
+    videoStillTrigger = UVC_Still_Busy();
+  }
+  videoSetCurSelector = 0;
+#if UAC_MIC_ENABLE
+  if (audioSetCurSelector == FU_MUTE_CONTROL)
+  {
+    UAC_Mute = (audioControl[0] != 0);
+    UAC_Control_Changed();
+  }
+  else if (audioSetCurSelector == FU_VOLUME_CONTROL)
+  {
+    s16 vol = (s16)(audioControl[0] | (audioControl[1] << 8));
+
+    if (vol < UAC_VOLUME_MIN)
+      vol = UAC_VOLUME_MIN;
+    else if (vol > UAC_VOLUME_MAX)
+      vol = UAC_VOLUME_MAX;
+    UAC_Volume = vol;
+    UAC_Control_Changed();
+  }
+  audioSetCurSelector = 0;
+#endif
+}
 
 /*******************************************************************************
 * Function Name  :
@@ -283,27 +396,112 @@ void UsbCamera_Status_Out(void)
 RESULT UsbCamera_Data_Setup(u8 RequestNo)
 {
     u8 *(*CopyRoutine)(u16);
+    u8 selector;
     CopyRoutine = NULL;
 
+    videoSetCurSelector = 0;
+#if UAC_MIC_ENABLE
+    audioSetCurSelector = 0;
+    //USBwIndex0 is the interface (low byte of wIndex), USBwIndex1 the entity ID
+    if ((pInformation->USBwIndex0 == UAC_AC_INTERFACE) && (pInformation->USBwIndex1 == UAC_FEATURE_UNIT_ID))
+    {
+        return Audio_Data_Setup(RequestNo);
+    }
+#endif
+    if ((pInformation->USBwIndex != 0x0100) ||
+        (pInformation->USBwValue == 0) || (pInformation->USBwValue > VS_STILL_IMAGE_TRIGGER_CONTROL))
+    {
+        return USB_UNSUPPORT;
+    }
+    selector = pInformation->USBwValue;     // 1:Probe Control  2:Commit control
+    if (selector >= VS_STILL_PROBE_CONTROL)
+    {
+        return Still_Data_Setup(RequestNo, selector);
+    }
 
-    if ((RequestNo == GET_CUR) || (RequestNo == SET_CUR))
+    switch (RequestNo)
     {
-        if(pInformation->USBwIndex == 0x0100)
-        {
-            if(pInformation->USBwValue == 0x0001)
-            {
-                // Probe Control
-                CopyRoutine = VideoProbeControl_Command;
-            }
-            else if(pInformation->USBwValue == 0x0002)
-            {
-                // Commit control
-                CopyRoutine = VideoCommitControl_Command;
-            }
-        }
+    case SET_CUR:
+        videoSetCurSelector = selector;
+        /* fall through */
+    case GET_CUR:
+        CopyRoutine = (selector == 0x01) ? VideoProbeControl_Command : VideoCommitControl_Command;
+        break;
+    case GET_MIN:
+        Video_Control_Fill(&videoScratchControl, 1, 1, UVC_Intervals[0]);
+        CopyRoutine = VideoScratchControl_Command;
+        break;
+    case GET_MAX:
+        Video_Control_Fill(&videoScratchControl, VS_FORMAT_MJPEG, UVC_Stream_MaxFrame(), UVC_Intervals[VS_NUM_INTERVALS - 1]);
+        CopyRoutine = VideoScratchControl_Command;
+        break;
+    case GET_DEF:
+        Video_Control_Fill(&videoScratchControl, VS_FORMAT_MJPEG, VS_DEF_FRAME, FRAME_INTERVEL);
+        CopyRoutine = VideoScratchControl_Command;
+        break;
+    case GET_LEN:
+        CopyRoutine = VideoControlLen_Command;
+        break;
+    case GET_INFO:
+        CopyRoutine = VideoControlInfo_Command;
+        break;
+    default:
+        return USB_UNSUPPORT;
     }
-    else
+
+    pInformation->Ctrl_Info.CopyData = CopyRoutine;
+    pInformation->Ctrl_Info.Usb_wOffset = 0;
+    (*CopyRoutine)(0);
+    return USB_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name  : Still_Data_Setup
+* Description    : Still image probe/commit and trigger requests (method 2).
+* Input          : RequestNo: class request. selector: 3, 4 or 5.
+* Output         : None.
+* Return         : USB_UNSUPPORT or USB_SUCCESS.
+*******************************************************************************/
+static RESULT Still_Data_Setup(u8 RequestNo, u8 selector)
+{
+    u8 *(*CopyRoutine)(u16);
+
+    switch (RequestNo)
     {
+    case SET_CUR:
+        videoSetCurSelector = selector;
+        /* fall through */
+    case GET_CUR:
+        if (selector == VS_STILL_PROBE_CONTROL)
+        {
+            CopyRoutine = StillProbeControl_Command;
+        }
+        else if (selector == VS_STILL_COMMIT_CONTROL)
+        {
+            CopyRoutine = StillCommitControl_Command;
+        }
+        else
+        {
+            videoStillTrigger = UVC_Still_Busy();
+            CopyRoutine = StillTrigger_Command;
+        }
+        break;
+    case GET_MIN:
+    case GET_MAX:
+    case GET_DEF:
+        if (selector == VS_STILL_IMAGE_TRIGGER_CONTROL)
+        {
+            return USB_UNSUPPORT;
+        }
+        CopyRoutine = StillDefControl_Command;
+        break;
+    case GET_LEN:
+        CopyRoutine = (selector == VS_STILL_IMAGE_TRIGGER_CONTROL) ? StillTriggerLen_Command : StillControlLen_Command;
+        break;
+    case GET_INFO:
+        CopyRoutine = VideoControlInfo_Command;
+        break;
+    default:
         return USB_UNSUPPORT;
     }
 
@@ -313,7 +511,72 @@ RESULT UsbCamera_Data_Setup(u8 RequestNo)
     return USB_SUCCESS;
 }
 
+#if UAC_MIC_ENABLE
+/*******************************************************************************
+* Function Name  : Audio_Data_Setup
+* Description    : Feature unit mute and volume requests, master channel only.
+*                  SET_CUR data is applied in UsbCamera_Status_In().
+* Input          : RequestNo: class request.
+* Output         : None.
+* Return         : USB_UNSUPPORT or USB_SUCCESS.
+*******************************************************************************/
+static RESULT Audio_Data_Setup(u8 RequestNo)
+{
+    u8 selector = pInformation->USBwValue1;
+    s16 vol;
+
+    if (pInformation->USBwValue0 != 0)
+    {
+        return USB_UNSUPPORT;
+    }
+    if (selector == FU_MUTE_CONTROL)
+    {
+        if ((RequestNo != GET_CUR) && (RequestNo != SET_CUR))
+        {
+            return USB_UNSUPPORT;
+        }
+        audioControl[0] = UAC_Mute;
+        audioControlSize = 1;
+    }
+    else if (selector == FU_VOLUME_CONTROL)
+    {
+        switch (RequestNo)
+        {
+        case SET_CUR:
+        case GET_CUR:
+            vol = UAC_Volume;
+            break;
+        case GET_MIN:
+            vol = UAC_VOLUME_MIN;
+            break;
+        case GET_MAX:
+            vol = UAC_VOLUME_MAX;
+            break;
+        case GET_RES:
+            vol = UAC_VOLUME_RES;
+            break;
+        default:
+            return USB_UNSUPPORT;
+        }
+        audioControl[0] = (u8)vol;
+        audioControl[1] = (u8)((u16)vol >> 8);
+        audioControlSize = 2;
+    }
+    else
+    {
+        return USB_UNSUPPORT;
+    }
+    if (RequestNo == SET_CUR)
+    {
+        audioSetCurSelector = selector;
+    }
 
+    pInformation->Ctrl_Info.CopyData = AudioControl_Command;
+    pInformation->Ctrl_Info.Usb_wOffset = 0;
+    AudioControl_Command(0);
+    return USB_SUCCESS;
+}
+#endif
 
 /*******************************************************************************
 * Function Name  :
@@ -382,17 +645,74 @@ u8 *UsbCamera_GetStringDescriptor(u16 Length)
 *******************************************************************************/
 RESULT UsbCamera_Get_Interface_Setting(u8 Interface, u8 AlternateSetting)
 {
-  if (AlternateSetting > 1)
+#if UAC_MIC_ENABLE
+  if (Interface == UAC_AC_INTERFACE)
+  {
+    return (AlternateSetting > 0) ? USB_UNSUPPORT : USB_SUCCESS;
+  }
+  else if (Interface == UAC_AS_INTERFACE)
+  {
+    return (AlternateSetting > 1) ? USB_UNSUPPORT : USB_SUCCESS;
+  }
+#endif
+  if (Interface > 1)
+  {
+    return USB_UNSUPPORT;
+  }
+  else if ((Interface == 0) && (AlternateSetting > 0))
   {
     return USB_UNSUPPORT;
   }
-  else if (Interface > 1)
+#if UVC_BULK_MODE
+  else if (AlternateSetting > 0)          /* bulk streaming has no alternate settings */
+#else
+  else if (AlternateSetting > VS_ALT_NUM)
+#endif
   {
     return USB_UNSUPPORT;
   }
   return USB_SUCCESS;
 }
 
+/*******************************************************************************
+* Function Name  : UsbCamera_SetInterface
+* Description    : SET_INTERFACE on the VideoStreaming interface, the packetizer
+*                  follows the max packet size of the selected alternate setting.
+*                  Alt 1 of the AudioStreaming interface starts the microphone.
+* Input          : None.
+* Output         : None.
+* Return         : None.
+*******************************************************************************/
+void UsbCamera_SetInterface(void)
+{
+  if (pInformation->USBwIndex0 == 1)
+  {
+    UVC_SetAltSetting(pInformation->USBwValue0);
+  }
+#if UAC_MIC_ENABLE
+  else if (pInformation->USBwIndex0 == UAC_AS_INTERFACE)
+  {
+    UAC_SetAltSetting(pInformation->USBwValue0);
+  }
+#endif
+}
+
+/*******************************************************************************
+* Function Name  : UsbCamera_ClearFeature
+* Description    : CLEAR_FEATURE(ENDPOINT_HALT) on the video endpoint, this is
+*                  how a host stops a bulk stream.
+* Input          : None.
+* Output         : None.
+* Return         : None.
+*******************************************************************************/
+void UsbCamera_ClearFeature(void)
+{
+  if (pInformation->USBwIndex0 == 0x81)
+  {
+    UVC_Stream_Stop();
+  }
+}
+
 
 /*******************************************************************************
 * Function Name  :
@@ -403,15 +723,7 @@ RESULT UsbCamera_Get_Interface_Setting(u8 Interface, u8 AlternateSetting)
 *******************************************************************************/
 u8* VideoProbeControl_Command(u16 Length)
 {
-    if (Length == 0)
-    {
-        pInformation->Ctrl_Info.Usb_wLength = pInformation->USBwLengths.w;
-        return NULL;
-    }
-    else
-    {
-        return((u8*)(&videoProbeControl));
-    }
+    return Video_Control_Copy(Length, (u8*)&videoProbeControl, sizeof(VideoControl));
 }
 
 /*******************************************************************************
@@ -422,20 +734,169 @@ u8* VideoProbeControl_Command(u16 Length)
 * Return         :
 *******************************************************************************/
 u8* VideoCommitControl_Command(u16 Length)
+{
+    return Video_Control_Copy(Length, (u8*)&videoCommitControl, sizeof(VideoControl));
+}
+
+u8* VideoScratchControl_Command(u16 Length)
+{
+    return Video_Control_Copy(Length, (u8*)&videoScratchControl, sizeof(VideoControl));
+}
+
+u8* VideoControlLen_Command(u16 Length)
+{
+    return Video_Control_Copy(Length, videoControlLen, sizeof(videoControlLen));
+}
+
+u8* VideoControlInfo_Command(u16 Length)
+{
+    return Video_Control_Copy(Length, &videoControlInfo, sizeof(videoControlInfo));
+}
+
+u8* StillProbeControl_Command(u16 Length)
+{
+    return Video_Control_Copy(Length, (u8*)&stillProbeControl, sizeof(StillControl));
+}
+
+u8* StillCommitControl_Command(u16 Length)
+{
+    return Video_Control_Copy(Length, (u8*)&stillCommitControl, sizeof(StillControl));
+}
+
+u8* StillDefControl_Command(u16 Length)
+{
+    return Video_Control_Copy(Length, (u8*)&stillDefControl, sizeof(StillControl));
+}
+
+u8* StillControlLen_Command(u16 Length)
+{
+    return Video_Control_Copy(Length, stillControlLen, sizeof(stillControlLen));
+}
+
+u8* StillTrigger_Command(u16 Length)
+{
+    return Video_Control_Copy(Length, &videoStillTrigger, sizeof(videoStillTrigger));
+}
+
+u8* StillTriggerLen_Command(u16 Length)
+{
+    return Video_Control_Copy(Length, stillTriggerLen, sizeof(stillTriggerLen));
+}
+
+#if UAC_MIC_ENABLE
+u8* AudioControl_Command(u16 Length)
+{
+    return Video_Control_Copy(Length, audioControl, audioControlSize);
+}
+#endif
+
+/*******************************************************************************
+* Function Name  : Video_Control_Copy
+* Description    : Common CopyData routine, never lets a SET_CUR write past buf.
+* Input          : Length: 0 to report the transfer length. buf/size: control data.
+* Output         : None.
+* Return         : buf + offset, NULL for the length query.
+*******************************************************************************/
+static u8* Video_Control_Copy(u16 Length, u8* buf, u16 size)
 {
     if (Length == 0)
     {
-        pInformation->Ctrl_Info.Usb_wLength = pInformation->USBwLengths.w;
+        //a UVC 1.0 host transfers only the first 26 bytes
+        pInformation->Ctrl_Info.Usb_wLength = size - pInformation->Ctrl_Info.Usb_wOffset;
+        if (pInformation->Ctrl_Info.Usb_wLength > pInformation->USBwLengths.w)
+        {
+            pInformation->Ctrl_Info.Usb_wLength = pInformation->USBwLengths.w;
+        }
         return NULL;
     }
-    else
+    return buf + pInformation->Ctrl_Info.Usb_wOffset;
+}
+
+/*******************************************************************************
+* Function Name  : Video_Control_Fill
+* Description    : Build a probe/commit answer for one format/frame/interval.
+*                  Fields the device does not support are returned as 0.
+* Input          : ctl: control to fill. format/frame: 1 based indexes.
+*                  interval: dwFrameInterval, 100ns units.
+* Output         : None.
+* Return         : None.
+*******************************************************************************/
+static void Video_Control_Fill(VideoControl* ctl, u8 format, u8 frame, u32 interval)
+{
+    u8 *p = (u8*)ctl;
+    const UVC_FrameType *size = UVC_Stream_Frame(format, frame);
+    u32 i;
+
+    for (i = 0; i < sizeof(VideoControl); i++)
     {
-        return((u8*)(&videoCommitControl));
+        p[i] = 0;
     }
+    ctl->bmHint[0] = 0x01;                  // dwFrameInterval is fixed
+    ctl->bFormatIndex[0] = format;
+    ctl->bFrameIndex[0] = frame;
+    SET_U32(ctl->dwFrameInterval, interval);
+    SET_U32(ctl->dwMaxVideoFrameSize, size->dwMaxVideoFrameSize);
+    SET_U32(ctl->dwMaxPayloadTransferSize, VS_MAX_PAYLOAD_SIZE(size->dwMaxVideoFrameSize));
+    SET_U32(ctl->dwClockFrequency, UVC_CLOCK_FREQ);
 }
 
+/*******************************************************************************
+* Function Name  : Video_Control_Clamp
+* Description    : Replace what the host asked for with the nearest supported
+*                  format, frame and interval.
+* Input          : ctl: probe or commit control written by SET_CUR.
+* Output         : None.
+* Return         : None.
+*******************************************************************************/
+static void Video_Control_Clamp(VideoControl* ctl)
+{
+    u8 format = ctl->bFormatIndex[0];
+    u8 frame = ctl->bFrameIndex[0];
+    u32 interval = MAKE_U32(ctl->dwFrameInterval);
+    u32 i, best;
 
-
+    if ((format == 0) || (format > VS_NUM_FORMATS))
+    {
+        format = VS_FORMAT_MJPEG;
+    }
+    if (format == VS_FORMAT_YUY2)
+    {
+        //lines are streamed through a fixed FIFO, every size fits
+        if ((frame == 0) || (frame > VS_YUY2_NUM_FRAMES))
+        {
+            frame = 1;
+        }
+        i = VS_YUY2_FIRST_INTERVAL;
+    }
+    else
+    {
+        if ((frame == 0) || (frame > VS_NUM_FRAMES))
+        {
+            frame = VS_DEF_FRAME;
+        }
+        //sizes the frame arena can not hold fall back to the largest one it can
+        if (frame > UVC_Stream_MaxFrame())
+        {
+            frame = UVC_Stream_MaxFrame();
+        }
+        i = 0;
+    }
+    if (interval == 0)
+    {
+        interval = UVC_Intervals[i];
+    }
+    //shortest supported interval that is not faster than the request
+    best = UVC_Intervals[VS_NUM_INTERVALS - 1];
+    for (; i < VS_NUM_INTERVALS; i++)
+    {
+        if (UVC_Intervals[i] >= interval)
+        {
+            best = UVC_Intervals[i];
+            break;
+        }
+    }
+    Video_Control_Fill(ctl, format, frame, best);
+}
 
 /******************* (C) COPYRIGHT 2011 xxxxxxxxxxxxxxx *****END OF FILE****/
 
@@ -33,15 +33,32 @@ typedef struct
 #define UsbCamera_GetConfiguration          NOP_Process
 //#define UsbCamera_SetConfiguration          NOP_Process
 #define UsbCamera_GetInterface              NOP_Process
-#define UsbCamera_SetInterface              NOP_Process
+//#define UsbCamera_SetInterface              NOP_Process
 #define UsbCamera_GetStatus                 NOP_Process
-#define UsbCamera_ClearFeature              NOP_Process
+//#define UsbCamera_ClearFeature              NOP_Process
 #define UsbCamera_SetEndPointFeature        NOP_Process
 #define UsbCamera_SetDeviceFeature          NOP_Process
 //#define UsbCamera_SetDeviceAddress          NOP_Process
 
 #define GET_CUR                     0x81
+#define GET_MIN                     0x82
+#define GET_MAX                     0x83
+#define GET_RES                     0x84
+#define GET_LEN                     0x85
+#define GET_INFO                    0x86
+#define GET_DEF                     0x87
 #define SET_CUR                     0x01
+
+//VideoStreaming interface control selectors
+#define VS_PROBE_CONTROL                    0x01
+#define VS_COMMIT_CONTROL                   0x02
+#define VS_STILL_PROBE_CONTROL              0x03
+#define VS_STILL_COMMIT_CONTROL             0x04
+#define VS_STILL_IMAGE_TRIGGER_CONTROL      0x05
+
+//Audio feature unit control selectors
+#define FU_MUTE_CONTROL                     0x01
+#define FU_VOLUME_CONTROL                   0x02
 #define SET_INTERFACE               0x0b
 #define REPORT_DESCRIPTOR           0x22
 
@@ -55,12 +72,26 @@ void UsbCamera_Status_Out (void);
 RESULT UsbCamera_Data_Setup(u8);
 RESULT UsbCamera_NoData_Setup(u8);
 RESULT UsbCamera_Get_Interface_Setting(u8 Interface, u8 AlternateSetting);
+void UsbCamera_SetInterface(void);
+void UsbCamera_ClearFeature(void);
 u8 *UsbCamera_GetDeviceDescriptor(u16 );
 u8 *UsbCamera_GetConfigDescriptor(u16);
 u8 *UsbCamera_GetStringDescriptor(u16);
 
 u8* VideoCommitControl_Command(u16 Length);
 u8* VideoProbeControl_Command(u16 Length);
+u8* VideoScratchControl_Command(u16 Length);
+u8* VideoControlLen_Command(u16 Length);
+u8* VideoControlInfo_Command(u16 Length);
+u8* StillProbeControl_Command(u16 Length);
+u8* StillCommitControl_Command(u16 Length);
+u8* StillDefControl_Command(u16 Length);
+u8* StillControlLen_Command(u16 Length);
+u8* StillTrigger_Command(u16 Length);
+u8* StillTriggerLen_Command(u16 Length);
+#if UAC_MIC_ENABLE
+u8* AudioControl_Command(u16 Length);
+#endif
 
 
 #endif /* __usb_prop_H */
@@ -5,86 +5,874 @@
 #include "usb_mem.h"
 
 #include "ov2640.h"
+#include "dvp.h"
+#include "frame_queue.h"
 
 
-#define CAMERA_SIZ_STREAMHD     2
+u8 UVC_Header[CAMERA_SIZ_STREAMHD];  //UVC payload header
+u16 UVC_PacketSize = VS_PACKET_SIZE_DEF;    //max packet size of the current alternate setting
+#if UVC_BULK_MODE
+static u8 UVC_BulkZLP = 0;           //last transfer ended on a full packet, a ZLP must follow
+#endif
+#if UVC_TX_PRESTAGE && !UVC_BULK_MODE
+#define UVC_TX_AHEAD            1    //a packet is built one 1ms frame before it goes out
+#else
+#define UVC_TX_AHEAD            0
+#endif
+static uint16_t UVC_TxStagedAddr;    //PMA buffer holding the next packet
+static int32_t UVC_TxStagedLen = -1; //its length, -1 while nothing is staged
+volatile u8 UVC_State = UVC_STATE_OFF;     //written by the USB interrupt and UVC_Stream_Process()
+static u8 UVC_SensorOn = 1;          //OV2640_Init() leaves the sensor running
+static volatile u8 UVC_StillState = UVC_STILL_IDLE;
+static u8 UVC_StillTimeout;
+static u8 UVC_HeldValid = 0;         //the frame held from the last FrameQueue_Pop() may be sent again
+static volatile u8 UVC_CommitPending = 0;   //commit received, sensor not yet reprogrammed
+static u8 UVC_Format = VS_FORMAT_MJPEG;     //what the sensor and DVP are set up for
+static u8 UVC_CommitFormat = VS_FORMAT_MJPEG;
+static u8 UVC_CommitFrame = VS_DEF_FRAME;
+static u32 UVC_CommitInterval = FRAME_INTERVEL;
+//sensor clock per UVC_Intervals[] row: {CLKRC, R_DVP_SP}
+//JPEG data rate drops with the frame rate, so PCLK is divided along with the sensor clock
+static const u8 UVC_SensorClock[VS_NUM_INTERVALS][2] =
+{
+    {0x00, 12},     //15fps, PCLK 4MHz
+    {0x01, 24},     //7.5fps, PCLK 2MHz
+    {0x02, 36},     //5fps, PCLK 1.33MHz
+    {0x04, 60},     //3fps, PCLK 0.8MHz
+};
+static volatile u32 UVC_SofCnt = 0;  //SOFs since reset
+static u32 UVC_FrameSof = 0;         //UVC_SofCnt when the current frame started
+static u32 UVC_FrameSofs = (FRAME_INTERVEL + 9999) / 10000;  //committed interval in 1ms frames, rounded up
+#if UVC_BULK_MODE
+static u8 UVC_BulkWait = 0;          //frame done early, EP1 left NAKing until the interval is over
+#else
+static u32 UVC_PackTotal = 0;        //packets in the current frame
+static u32 UVC_PackSent = 0;         //data packets of it sent so far
+#endif
+volatile u32 UVC_FrameSentCnt = 0;   //frames started on EP1, compare with DVP_FrameCnt
+volatile u32 UVC_FrameRepeatCnt = 0; //of those, repeats of the previous frame (UVC_REPEAT_FRAME)
+volatile u32 UVC_EmptyPackCnt = 0;   //header-only isochronous packets
+//YUY2 line FIFO in the frame arena, UVC_YuvLine() fills it and UVC_SendYuvPack() drains it
+static uint8_t* UVC_YuvFifo;         //UVC_YUV_FIFO_DEPTH entries of VS_YUY2_LINE_MAX bytes
+static u16 UVC_YuvLineNo[UVC_YUV_FIFO_DEPTH];   //output line held by each entry
+static volatile u32 UVC_YuvHead = 0; //next entry to fill, producer only
+static volatile u32 UVC_YuvTail = 0; //next entry to send, consumer only
+static u16 UVC_YuvWidth;             //output frame size
+static u16 UVC_YuvHeight;
+static u16 UVC_YuvCropX;             //bytes skipped at the start of every sensor line
+static u16 UVC_YuvY;                 //output line the packetizer expects next
+static u16 UVC_YuvOff;               //bytes of the tail entry already sent
+static volatile u32 UVC_YuvTime;     //DWT cycle count when line 0 of the newest frame arrived
+volatile u32 UVC_YuvDropCnt = 0;     //lines lost because the FIFO was full
 
-u8 UVC_TxBuf[PACKET_SIZE];          //USB TX Buffer
+#if UVC_IRQ_HIST
+volatile u32 UVC_IrqHist[UVC_IRQ_HIST_BINS];    //USB HP interrupt duration, log2 bins
+volatile u32 UVC_IrqMax = 0;                    //longest one in cycles
+#endif
 vs32 FrameSentLen = 0;               //ǰFrameѷByte Number
 
 /* Private function prototypes -----------------------------------------------*/
+static void UVC_BuildPack(void);
+static uint16_t UVC_TxBuf(void);
+static void UVC_TxSend(uint16_t pmaaddr, uint32_t len);
+static void UVC_TxStage(uint16_t pmaaddr, uint32_t len);
+static void UVC_TxPack(uint32_t hdrlen, const uint8_t* payload, uint32_t len);
+static void UVC_TxYuvPack(uint32_t hdrlen, uint32_t len);
+static void UVC_SendYuvPack(void);
+static void UVC_YuvLine(uint16_t line, uint8_t* buf, uint16_t len);
+static void UVC_Yuv_Config(const UVC_FrameType *frame);
+static Frame_SlotType* UVC_PopFrame(void);
+static void UVC_SendIdle(void);
+static void UVC_Still_Process(void);
+static void UVC_StampSCR(void);
+static void UVC_Stream_Apply(void);
+static void UVC_WritePack(uint16_t wPMABufAddr, uint32_t hdrlen, const uint8_t* payload, uint32_t len);
 
+//EP1 IN completion, or the first packet of a bulk transfer
+//The staged packet is handed over first, with UVC_TX_PRESTAGE the next one is then
+//built into the half just freed, so the copy is out of the window before the next
+//IN token. Without it, or when nothing was staged, the packet is built here first.
 void UVC_SendPack_Irq(void)
 {
-    uint32_t datalen;
-    uint8_t *payload;
+    if (UVC_TxStagedLen < 0)
+        UVC_BuildPack();
+    if (UVC_TxStagedLen < 0)
+        return;                 //bulk waiting for the interval or for YUY2 lines
+    UVC_TxSend(UVC_TxStagedAddr, UVC_TxStagedLen);
+    UVC_TxStagedLen = -1;
+#if UVC_TX_AHEAD
+    UVC_BuildPack();
+#endif
+}
 
-    payload = UVC_TxBuf + CAMERA_SIZ_STREAMHD;
+//Isochronous: every packet starts with a payload header, EOF on the last one
+//Bulk: one transfer per frame, the header only leads the first packet and the
+//transfer ends with a short packet or a ZLP
+//Frames start no faster than the committed interval and only when a new frame is
+//queued, unless UVC_REPEAT_FRAME is set. In isochronous mode the packets of a frame
+//are spread over the interval and the 1ms frames left over carry a header-only
+//packet. In bulk mode EP1 just NAKs until UVC_Stream_Sof() restarts it.
+static void UVC_BuildPack(void)
+{
+    uint32_t datalen;
+    uint32_t hdrlen = CAMERA_SIZ_STREAMHD;
+    uint32_t elapsed = UVC_SofCnt + UVC_TX_AHEAD - UVC_FrameSof;
+    Frame_SlotType *slot;
 
+    if (UVC_Format == VS_FORMAT_YUY2)
+    {
+        UVC_SendYuvPack();
+        return;
+    }
     if (FrameSentLen >= FrameLen)
     {
-        FrameSentLen = 0;
-        //֡Bufĸڽɵ״̬
-        if(FrameBuf_1_Ready)
+#if UVC_BULK_MODE
+        if (UVC_BulkZLP)
+        {
+            UVC_BulkZLP = 0;
+            UVC_TxPack(0, 0, 0);
+            return;
+        }
+#endif
+        if (elapsed < UVC_FrameSofs)
         {
-          Frame_SendPtr = FrameBuf_1_Addr;
-          FrameLen = FrameBuf_1_Len;
+            UVC_SendIdle();
+            return;
+        }
+        //oldest captured frame
+        slot = UVC_PopFrame();
+        if(slot)
+        {
+          Frame_SendPtr = slot->buf;
+          FrameLen = slot->len;
+          //PTS: capture start of the frame, a repeated frame keeps its PTS
+          UVC_Header[2] = (u8)slot->time;
+          UVC_Header[3] = (u8)(slot->time >> 8);
+          UVC_Header[4] = (u8)(slot->time >> 16);
+          UVC_Header[5] = (u8)(slot->time >> 24);
         }
         else
         {
-          Frame_SendPtr = FrameBuf_2_Addr;
-          FrameLen = FrameBuf_2_Len;
+#if UVC_REPEAT_FRAME
+            if (UVC_HeldValid == 0)
+            {
+                UVC_SendIdle();
+                return;
+            }
+            UVC_FrameRepeatCnt++;   //nothing new, the held frame goes out again
+#else
+            UVC_SendIdle();         //nothing new, check again next 1ms frame
+            return;
+#endif
         }
-        //ÿ֡ͼʼʼpayload
-        UVC_TxBuf[0] = 0x02;
-        UVC_TxBuf[1] &= 0x01;
-        UVC_TxBuf[1] ^= 0x01;
+        UVC_FrameSentCnt++;
+        UVC_FrameSof = UVC_SofCnt + UVC_TX_AHEAD;
+        elapsed = 0;
+        FrameSentLen = 0;
+        //ÿ֡ͼʼʼpayload header
+        UVC_Header[0] = CAMERA_SIZ_STREAMHD;
+        UVC_Header[1] &= 0x01;
+        UVC_Header[1] ^= 0x01;
+        UVC_Header[1] |= 0x8C;       //EOH, SCR and PTS present
+        if (slot && (slot->tag == FRAME_TAG_STILL))
+            UVC_Header[1] |= 0x20;   //STI, still image
+#if UVC_BULK_MODE
+        UVC_Header[1] |= 0x02;       //the transfer carries the whole frame
+#else
+        datalen = UVC_PacketSize - CAMERA_SIZ_STREAMHD;
+        UVC_PackTotal = (FrameLen + datalen - 1) / datalen;
+        UVC_PackSent = 0;
+#endif
+    }
+#if UVC_BULK_MODE
+    else
+    {
+        hdrlen = 0;
+    }
+#else
+    //packet n of the frame is not sent before 1ms frame n*interval/packets
+    else if (UVC_PackSent * UVC_FrameSofs >= (elapsed + 1) * UVC_PackTotal)
+    {
+        UVC_StampSCR();
+        UVC_TxPack(CAMERA_SIZ_STREAMHD, 0, 0);
+        UVC_EmptyPackCnt++;
+        return;
+    }
+    UVC_PackSent++;
+#endif
 
-        datalen = PACKET_SIZE - CAMERA_SIZ_STREAMHD;
-        bufCopy(Frame_SendPtr + FrameSentLen, payload, datalen);
-        //TX Buffer͵USB PMA Buffer
-        UserToPMABufferCopy(UVC_TxBuf, ENDP1_BUF1Addr, PACKET_SIZE);
-        FrameSentLen = datalen;
+    if (hdrlen)
+        UVC_StampSCR();
 
+    datalen = UVC_PacketSize - hdrlen;
+    //жǷһ
+    if (FrameSentLen + datalen >= FrameLen)
+    {
+        datalen = FrameLen - FrameSentLen;
+#if UVC_BULK_MODE
+        UVC_BulkZLP = (hdrlen + datalen == UVC_PacketSize);
+#else
+        UVC_Header[1] |= 0x02;       //ӽ
+#endif
     }
-    else
+
+    UVC_TxPack(hdrlen, Frame_SendPtr + FrameSentLen, datalen);
+    FrameSentLen += datalen;
+}
+
+//YUY2 packetizer, lines come from the FIFO while the sensor is still sending the frame
+//A frame starts at its line 0 and takes every line in order. Isochronous packets carry
+//whatever is ready, bulk ones wait in UVC_Stream_Sof() for a full packet. A line lost
+//to a full FIFO ends the frame early, with the error bit on isochronous and as a short
+//transfer on bulk, and the rest of that frame is skipped.
+static void UVC_SendYuvPack(void)
+{
+    uint32_t hdrlen = CAMERA_SIZ_STREAMHD;
+    uint32_t want, ready, head, i;
+    u16 y;
+    u8 gap = 0;
+
+#if UVC_BULK_MODE
+    if (UVC_BulkZLP)
     {
-        //֡ͼĺ
-        datalen = PACKET_SIZE - CAMERA_SIZ_STREAMHD;
-            //жǷһ
-        if (FrameSentLen + datalen >= FrameLen)
+        UVC_BulkZLP = 0;
+        UVC_TxPack(0, 0, 0);
+        return;
+    }
+#endif
+    if ((u32)FrameSentLen >= FrameLen)
+    {
+        //drop what is left of a broken frame, wait for the first line of the next one
+        head = UVC_YuvHead;
+        while ((UVC_YuvTail != head) && (UVC_YuvLineNo[UVC_YuvTail & (UVC_YUV_FIFO_DEPTH - 1)] != 0))
+            UVC_YuvTail++;
+        if (UVC_YuvTail == head)
+        {
+            UVC_SendIdle();
+            return;
+        }
+        UVC_FrameSentCnt++;
+        FrameLen = (u32)UVC_YuvWidth * UVC_YuvHeight * 2;
+        FrameSentLen = 0;
+        UVC_YuvY = 0;
+        UVC_YuvOff = 0;
+        UVC_Header[0] = CAMERA_SIZ_STREAMHD;
+        UVC_Header[1] &= 0x01;
+        UVC_Header[1] ^= 0x01;
+        UVC_Header[1] |= 0x8C;       //EOH, SCR and PTS present
+        UVC_Header[2] = (u8)UVC_YuvTime;
+        UVC_Header[3] = (u8)(UVC_YuvTime >> 8);
+        UVC_Header[4] = (u8)(UVC_YuvTime >> 16);
+        UVC_Header[5] = (u8)(UVC_YuvTime >> 24);
+#if UVC_BULK_MODE
+        UVC_Header[1] |= 0x02;       //the transfer carries the whole frame
+#endif
+    }
+#if UVC_BULK_MODE
+    if (FrameSentLen != 0)
+        hdrlen = 0;                  //a wait for lines may come between frame start and the first packet
+#endif
+    want = UVC_PacketSize - hdrlen;
+    if (want > FrameLen - FrameSentLen)
+        want = FrameLen - FrameSentLen;
+
+    //bytes of consecutive lines ready, up to the first missing one
+    head = UVC_YuvHead;
+    __DMB();
+    ready = 0;
+    y = UVC_YuvY;
+    for (i = UVC_YuvTail; (i != head) && (ready < want); i++, y++)
+    {
+        if (UVC_YuvLineNo[i & (UVC_YUV_FIFO_DEPTH - 1)] != y)
+        {
+            gap = 1;
+            break;
+        }
+        ready += UVC_YuvWidth * 2;
+        if (i == UVC_YuvTail)
+            ready -= UVC_YuvOff;
+    }
+    if (ready > want)
+        ready = want;
+
+#if UVC_BULK_MODE
+    if (ready < want)
+    {
+        if (gap == 0)
         {
-            datalen = FrameLen - FrameSentLen;
-            UVC_TxBuf[1] |= 0x02;       //ӽ
+            UVC_BulkWait = 1;        //not captured yet
+            return;
         }
-        bufCopy(Frame_SendPtr + FrameSentLen, payload, datalen);
-        FrameSentLen += datalen;
+        FrameLen = FrameSentLen + ready;    //short packet, the host drops the frame
     }
+    else if (FrameSentLen + ready >= FrameLen)
+    {
+        UVC_BulkZLP = (hdrlen + ready == UVC_PacketSize);
+    }
+#else
+    if (gap && (ready == 0))
+    {
+        UVC_Header[1] |= 0x42;       //ERR and EOF, the frame is incomplete
+        FrameLen = FrameSentLen;
+    }
+    else if (FrameSentLen + ready >= FrameLen)
+    {
+        UVC_Header[1] |= 0x02;       //ӽ
+    }
+    else if (ready == 0)
+    {
+        UVC_EmptyPackCnt++;
+    }
+#endif
+    if (hdrlen)
+        UVC_StampSCR();
+    UVC_TxYuvPack(hdrlen, ready);
+}
+
+//DVP line handler in YUY2 mode, runs in the DMA interrupt
+//Every UVC_YUV_DECIM-th line is kept. Of those, a word Y0 U0 Y1 V0 of every
+//UVC_YUV_DECIM-th one gets the luma of the next kept pixel: Y0 U0 Y2 V0 for 2.
+//A full FIFO drops the line, UVC_SendYuvPack() sees the gap.
+static void UVC_YuvLine(uint16_t line, uint8_t* buf, uint16_t len)
+{
+    const uint32_t *src;
+    uint32_t *dst;
+    uint32_t head = UVC_YuvHead;
+    u16 y = line / UVC_YUV_DECIM;
+    u16 i;
 
+    if ((line % UVC_YUV_DECIM) || (y >= UVC_YuvHeight))
+        return;
+    if (head - UVC_YuvTail >= UVC_YUV_FIFO_DEPTH)
+    {
+        UVC_YuvDropCnt++;
+        return;
+    }
+    if (y == 0)
+        UVC_YuvTime = DWT->CYCCNT;
+
+    src = (const uint32_t *)(buf + UVC_YuvCropX);
+    dst = (uint32_t *)(UVC_YuvFifo + (head & (UVC_YUV_FIFO_DEPTH - 1)) * VS_YUY2_LINE_MAX);
+    for (i = UVC_YuvWidth / 2; i != 0; i--)
+    {
+#if UVC_YUV_DECIM > 1
+        *dst++ = (src[0] & 0xFF00FFFF) | ((src[UVC_YUV_DECIM / 2] & 0xFF) << 16);
+#else
+        *dst++ = src[0];
+#endif
+        src += UVC_YUV_DECIM;
+    }
+    UVC_YuvLineNo[head & (UVC_YUV_FIFO_DEPTH - 1)] = y;
+    __DMB();                //line must be visible before the consumer sees the new head
+    UVC_YuvHead = head + 1;
+}
+
+//Next frame to send, still configuration frames nobody waits for are dropped
+//and a still is never repeated as a video frame
+static Frame_SlotType* UVC_PopFrame(void)
+{
+    Frame_SlotType *slot;
+
+    while ((slot = FrameQueue_Pop()) != 0)
+    {
+        if (slot->len == 0)
+        {
+            UVC_HeldValid = 0;      //no complete JPEG, the held frame went with the pop
+            continue;
+        }
+        if (slot->tag == FRAME_TAG_VIDEO)
+        {
+            UVC_HeldValid = 1;
+            return slot;
+        }
+        UVC_HeldValid = 0;
+        if (UVC_StillState == UVC_STILL_WAIT)
+        {
+            UVC_StillState = UVC_STILL_SENDING;
+            return slot;
+        }
+    }
+    return 0;
+}
+
+//No frame data due: a header-only packet keeps the isochronous pipe going,
+//a bulk EP1 is left NAKing until UVC_Stream_Sof() tries again
+static void UVC_SendIdle(void)
+{
+#if UVC_BULK_MODE
+    UVC_BulkWait = 1;
+#else
+    UVC_Header[1] &= 0x01;   //FID of the last frame, no EOF
+    UVC_Header[1] |= 0x8C;
+    UVC_StampSCR();
+    UVC_TxPack(CAMERA_SIZ_STREAMHD, 0, 0);
+    UVC_EmptyPackCnt++;
+#endif
+}
+
+//SCR: source clock and USB frame number at the time the packet is built
+static void UVC_StampSCR(void)
+{
+    uint32_t stc = DWT->CYCCNT;
+    uint16_t sof = _GetFRNUM() & FRNUM_FN;
+
+    UVC_Header[6] = (u8)stc;
+    UVC_Header[7] = (u8)(stc >> 8);
+    UVC_Header[8] = (u8)(stc >> 16);
+    UVC_Header[9] = (u8)(stc >> 24);
+    UVC_Header[10] = (u8)sof;
+    UVC_Header[11] = (u8)(sof >> 8);
+}
+
+//USB SOF, once per 1ms frame
+void UVC_Stream_Sof(void)
+{
+    UVC_SofCnt++;
+#if UVC_BULK_MODE
+    if (UVC_BulkWait && (UVC_State == UVC_STATE_BUSY) && (UVC_SofCnt - UVC_FrameSof >= UVC_FrameSofs))
+    {
+        UVC_BulkWait = 0;
+        UVC_SendPack_Irq();
+    }
+#endif
+}
+
+//Account one USB HP interrupt, cycles measured by the handler from entry to exit
+void UVC_IrqHist_Add(u32 cycles)
+{
+#if UVC_IRQ_HIST
+    u32 bin = cycles ? 31 - __CLZ(cycles) : 0;
+
+    if (bin >= UVC_IRQ_HIST_BINS)
+        bin = UVC_IRQ_HIST_BINS - 1;
+    UVC_IrqHist[bin]++;
+    if (cycles > UVC_IrqMax)
+        UVC_IrqMax = cycles;
+#else
+    (void)cycles;
+#endif
+}
+
+//Free EP1 ping-pong buffer
+static uint16_t UVC_TxBuf(void)
+{
     //USB˫ģʽݰ
     if(_GetENDPOINT(ENDP1) & EP_DTOG_RX)    //EP_DTOG_RX ->ʹõBUF1
     {
         // User use buffer0
-        UserToPMABufferCopy(UVC_TxBuf, ENDP1_BUF0Addr, PACKET_SIZE);
-        SetEPDblBuf0Count(ENDP1, EP_DBUF_IN, PACKET_SIZE);
+        return ENDP1_BUF0Addr;
     }
+    // User use buffer1
+    return ENDP1_BUF1Addr;
+}
+
+//Hand the buffer from UVC_TxBuf() to the USB core
+static void UVC_TxSend(uint16_t pmaaddr, uint32_t len)
+{
+    if(pmaaddr == ENDP1_BUF0Addr)
+        SetEPDblBuf0Count(ENDP1, EP_DBUF_IN, len);
     else
+        SetEPDblBuf1Count(ENDP1, EP_DBUF_IN, len);
+    _ToggleDTOG_RX(ENDP1);
+}
+
+//Packet written, UVC_SendPack_Irq() hands it over
+static void UVC_TxStage(uint16_t pmaaddr, uint32_t len)
+{
+    UVC_TxStagedAddr = pmaaddr;
+    UVC_TxStagedLen = len;
+}
+
+//Write one packet to the free EP1 ping-pong buffer
+static void UVC_TxPack(uint32_t hdrlen, const uint8_t* payload, uint32_t len)
+{
+    uint16_t pmaaddr = UVC_TxBuf();
+
+    UVC_WritePack(pmaaddr, hdrlen, payload, len);
+    UVC_TxStage(pmaaddr, hdrlen + len);
+}
+
+//Header + len bytes of FIFO lines in one packet, an entry is released once all of it is sent
+//Lines and packets are an even number of bytes, so every piece starts on a PMA halfword
+static void UVC_TxYuvPack(uint32_t hdrlen, uint32_t len)
+{
+    uint16_t pmaaddr = UVC_TxBuf();
+    uint16_t addr = pmaaddr + hdrlen;
+    uint32_t linelen = UVC_YuvWidth * 2;
+    uint32_t n, left = len;
+
+    UVC_WritePack(pmaaddr, hdrlen, 0, 0);
+    while (left)
     {
-        // User use buffer1
-        UserToPMABufferCopy(UVC_TxBuf, ENDP1_BUF1Addr, PACKET_SIZE);
-        SetEPDblBuf1Count(ENDP1, EP_DBUF_IN, PACKET_SIZE);
+        n = linelen - UVC_YuvOff;
+        if (n > left)
+            n = left;
+        UVC_WritePack(addr, 0, UVC_YuvFifo + (UVC_YuvTail & (UVC_YUV_FIFO_DEPTH - 1)) * VS_YUY2_LINE_MAX + UVC_YuvOff, n);
+        addr += n;
+        left -= n;
+        UVC_YuvOff += n;
+        if (UVC_YuvOff == linelen)
+        {
+            UVC_YuvOff = 0;
+            UVC_YuvTail++;
+            UVC_YuvY++;
+        }
     }
-    _ToggleDTOG_RX(ENDP1);
+    FrameSentLen += len;
+    UVC_TxStage(pmaaddr, hdrlen + len);
+}
+
+//SET_INTERFACE on the VideoStreaming interface, called from the USB interrupt
+//alt 0 stops the stream, any other selects its packet size and starts it
+void UVC_SetAltSetting(u8 alt)
+{
+#define UVC_ALT_PACKET_SIZE(alt, size)  size,
+    static const u16 AltPacketSize[VS_ALT_NUM + 1] =
+    {
+        0, VS_ALT_LIST(UVC_ALT_PACKET_SIZE)
+    };
+
+    if (alt == 0)
+    {
+        UVC_Stream_Stop();
+    }
+    else if (alt <= VS_ALT_NUM)
+    {
+        UVC_PacketSize = AltPacketSize[alt];
+        UVC_Stream_Start();
+    }
+}
+
+//Host wants video, called from the USB interrupt
+//UVC_Stream_Process() wakes the sensor and arms EP1 once a fresh frame is captured
+void UVC_Stream_Start(void)
+{
+    if (UVC_State == UVC_STATE_OFF)
+        UVC_State = UVC_STATE_READY;
+}
+
+//Host stopped the stream or the bus was reset, called from the USB interrupt
+//EP1 is silenced here, UVC_Stream_Process() stops capture and powers the sensor down
+void UVC_Stream_Stop(void)
+{
+    UVC_State = UVC_STATE_OFF;
+    if (UVC_StillState != UVC_STILL_IDLE)
+    {
+        UVC_StillState = UVC_STILL_IDLE;
+        FrameQueue_SetTag(FRAME_TAG_VIDEO);
+        UVC_CommitPending = 1;      //sensor may be left at the still size
+    }
+#if UVC_BULK_MODE
+    _SetEPTxStatus(ENDP1, EP_TX_NAK);
+#else
+    _SetEPTxStatus(ENDP1, EP_TX_DIS);
+#endif
+}
+
+//VS_COMMIT_CONTROL accepted, called from the USB interrupt
+//SCCB is far too slow for interrupt context, UVC_Stream_Process() applies it
+void UVC_Stream_Commit(u8 format, u8 frame, u32 interval)
+{
+    //a new capture mode, or a new YUY2 size, needs capture stopped: restart through READY
+    if ((UVC_State != UVC_STATE_OFF) && ((format != UVC_CommitFormat) || (format == VS_FORMAT_YUY2)))
+    {
+        UVC_Stream_Stop();
+        UVC_Stream_Start();
+    }
+    UVC_CommitFormat = format;
+    UVC_CommitFrame = frame;
+    UVC_CommitInterval = interval;
+    //YUY2 lines are paced by the sensor, only JPEG frames wait for the interval
+    UVC_FrameSofs = (format == VS_FORMAT_YUY2) ? 0 : (interval + 9999) / 10000;
+    UVC_CommitPending = 1;
+#if UVC_BULK_MODE
+    UVC_Stream_Start();     //bulk has no alternate setting, the commit starts the stream
+#endif
+}
+
+//Streaming state machine, call from main loop
+//OFF:        sensor in power down, no capture, EP1 silent
+//READY:      stream requested, wake the sensor and restart capture with an empty queue
+//NEED_FRAME: capture running, EP1 is armed as soon as the first new frame is queued
+//BUSY:       EP1 is streaming
+void UVC_Stream_Process(void)
+{
+    switch (UVC_State)
+    {
+    case UVC_STATE_OFF:
+        if (UVC_SensorOn)
+        {
+            EXTI_Disable(EXTI1_IRQn);
+            DVP_Frame_Abort();
+            OV2640_PWDN = 1;
+            UVC_SensorOn = 0;
+        }
+        break;
+
+    case UVC_STATE_READY:
+        EXTI_Disable(EXTI1_IRQn);   //a stop and start may have come too close together to pass OFF
+        DVP_Frame_Abort();
+        if (UVC_SensorOn == 0)
+        {
+            OV2640_PWDN = 0;
+            UVC_SensorOn = 1;
+            Delay_ms(2);        //registers are kept in power down, only the clocks restart
+        }
+        UVC_Stream_Apply();     //before capture starts so no frame has the old size
+        FrameQueue_Flush();
+        UVC_YuvHead = 0;
+        UVC_YuvTail = 0;
+        EXTI_ClearIntPendingBit(EXTI_Line1);
+        NVIC_ClearPendingIRQ(EXTI1_IRQn);
+        EXTI_Enable(EXTI1_IRQn);
+        __disable_irq();
+        if (UVC_State == UVC_STATE_READY)
+            UVC_State = UVC_STATE_NEED_FRAME;
+        __enable_irq();
+        break;
+
+    case UVC_STATE_NEED_FRAME:
+        //YUY2 starts right away, header-only packets until line 0 arrives
+        if ((UVC_Format == VS_FORMAT_MJPEG) && (FrameQueue_Count() == 0))
+            break;
+        __disable_irq();
+        if (UVC_State == UVC_STATE_NEED_FRAME)
+        {
+            FrameSentLen = 0;
+            FrameLen = 0;       //the first packet pops the new frame
+            UVC_HeldValid = 0;
+            UVC_FrameSof = UVC_SofCnt - UVC_FrameSofs;
+            UVC_TxStagedLen = -1;
+#if UVC_BULK_MODE
+            UVC_BulkZLP = 0;
+            UVC_BulkWait = 0;
+            UVC_SendPack_Irq();     //bulk IN only transmits once a buffer is filled, prime the first one
+#endif
+            //ʹUSB
+            _SetEPTxStatus(ENDP1, EP_TX_VALID);
+            UVC_State = UVC_STATE_BUSY;
+        }
+        __enable_irq();
+        break;
+
+    default:
+        UVC_Stream_Apply();
+        UVC_Still_Process();
+        break;
+    }
+}
+
+//USB suspend, called from the main loop before STOP
+//a running stream is parked in READY so UVC_Stream_Process() restarts capture after resume,
+//the sensor keeps its registers in power down so only PWDN has to be released then
+void UVC_Stream_Suspend(void)
+{
+    __disable_irq();
+    if (UVC_State != UVC_STATE_OFF)
+    {
+        UVC_Stream_Stop();
+        UVC_State = UVC_STATE_READY;
+    }
+    __enable_irq();
+    EXTI_Disable(EXTI1_IRQn);
+    DVP_Frame_Abort();
+    TMR_Cmd(DVP_PCLK_TMR, DISABLE);
+    if (UVC_SensorOn)
+    {
+        OV2640_PWDN = 1;
+        UVC_SensorOn = 0;
+    }
+}
+
+void UVC_Stream_Resume(void)
+{
+    TMR_Cmd(DVP_PCLK_TMR, ENABLE);
+}
+
+//VS_STILL_IMAGE_TRIGGER_CONTROL set to 1, called from the USB interrupt
+//Method 2 stills travel inside the running stream, so it is ignored when not streaming
+//MJPEG, the only format with a still image frame descriptor
+void UVC_Still_Trigger(void)
+{
+    if ((UVC_State == UVC_STATE_BUSY) && (UVC_Format == VS_FORMAT_MJPEG) && (UVC_StillState == UVC_STILL_IDLE))
+        UVC_StillState = UVC_STILL_TRIGGER;
+}
 
+//1 while a still is pending, read back through VS_STILL_IMAGE_TRIGGER_CONTROL
+u8 UVC_Still_Busy(void)
+{
+    return UVC_StillState != UVC_STILL_IDLE;
+}
+
+//Switch the sensor to the still size for one frame and back, called while streaming
+//TRIGGER: reconfigure, frames captured from now on are tagged as still
+//WAIT:    UVC_PopFrame() picks the first still frame and moves on to SENDING
+//SENDING: the still is held by the packetizer, restore the committed video size
+static void UVC_Still_Process(void)
+{
+    u8 restore = 0;
+
+    switch (UVC_StillState)
+    {
+    case UVC_STILL_TRIGGER:
+        //without room for a full size still the next frame at the video size is sent as still
+        if (FrameQueue_MaxRoom() >= VS_STILL_SIZE)
+        {
+            OV2640_OutSize_Set(VS_STILL_WIDTH, VS_STILL_HEIGHT);
+            FrameQueue_SetRoom(VS_STILL_SIZE);
+        }
+        FrameQueue_SetTag(FRAME_TAG_STILL);
+        UVC_StillTimeout = UVC_STILL_TIMEOUT;
+        UVC_StillState = UVC_STILL_WAIT;
+        break;
+
+    case UVC_STILL_WAIT:
+        if (--UVC_StillTimeout != 0)
+            break;
+        __disable_irq();            //no still arrived, give up unless it just did
+        if (UVC_StillState == UVC_STILL_WAIT)
+            UVC_StillState = UVC_STILL_SENDING;
+        __enable_irq();
+        restore = 1;
+        break;
+
+    case UVC_STILL_SENDING:
+        restore = 1;
+        break;
+    }
+
+    if (restore)
+    {
+        UVC_CommitPending = 1;
+        UVC_Stream_Apply();
+        FrameQueue_SetTag(FRAME_TAG_VIDEO);
+        UVC_StillState = UVC_STILL_IDLE;
+    }
 }
 
-void bufCopy(u8* srcPtr,u8* desPtr, u32 len)
+//Reprogram the sensor for the last committed frame size and interval
+static void UVC_Stream_Apply(void)
 {
-  while(len)
-  {
-    *desPtr=*srcPtr;
-    desPtr++;
-    srcPtr++;
-    len--;
-  }
+    const UVC_FrameType *frame;
+    u32 i;
+
+    if ((UVC_CommitPending == 0) || (UVC_SensorOn == 0))
+        return;
+    //YUY2 reconfigures the DVP, only done in READY while VSYNC is off
+    if (((UVC_CommitFormat == VS_FORMAT_YUY2) || (UVC_Format == VS_FORMAT_YUY2)) && (UVC_State != UVC_STATE_READY))
+        return;
+    UVC_CommitPending = 0;
+
+    frame = UVC_Stream_Frame(UVC_CommitFormat, UVC_CommitFrame);
+    if (UVC_CommitFormat == VS_FORMAT_YUY2)
+    {
+        UVC_Yuv_Config(frame);
+    }
+    else
+    {
+        if (UVC_Format != VS_FORMAT_MJPEG)
+        {
+            OV2640_JPEG_Mode();
+            DVP_Frame_Config();
+        }
+        //all sizes are 4:3 like the full UXGA window, the DSP only has to scale
+        OV2640_OutSize_Set(frame->wWidth, frame->wHeight);
+        FrameQueue_SetRoom(frame->dwMaxVideoFrameSize);
+    }
+    UVC_Format = UVC_CommitFormat;
+    //the negotiation only commits UVC_Intervals[] values
+    for (i = 0; i < VS_NUM_INTERVALS - 1; i++)
+    {
+        if (UVC_Intervals[i] == UVC_CommitInterval)
+            break;
+    }
+    ov2640_speed_set(UVC_SensorClock[i][0], UVC_SensorClock[i][1]);
+}
+
+//Sensor and DVP setup for a YUY2 frame size, VSYNC EXTI must be off
+//The sensor outputs UVC_YUV_DECIM times the frame height at 4:3, UVC_YuvLine() brings it
+//down and crops the sides of the 11:9 size. No frame is queued in this mode, so the
+//DVP line buffer and the line FIFO take the frame arena.
+static void UVC_Yuv_Config(const UVC_FrameType *frame)
+{
+    uint32_t size;
+    uint8_t *arena = FrameQueue_RawBuf(&size);
+    u16 sh = frame->wHeight * UVC_YUV_DECIM;
+    u16 sw = sh / 3 * 4;
+
+    UVC_YuvWidth = frame->wWidth;
+    UVC_YuvHeight = frame->wHeight;
+    UVC_YuvCropX = (sw / UVC_YUV_DECIM - frame->wWidth) * UVC_YUV_DECIM;    //half the spare pixels, 2 bytes each
+    UVC_YuvFifo = arena + sw * 4;           //after the two sensor lines
+    OV2640_YUV422_Mode();
+    OV2640_OutSize_Set(sw, sh);
+    DVP_Line_Config(arena, sw * 2, UVC_YuvLine);
+}
+
+//Largest bFrameIndex whose frames fit twice in the frame arena, one being sent
+//while the next is captured. Without the extended SRAM this stops at 320x240.
+u8 UVC_Stream_MaxFrame(void)
+{
+    u8 frame = VS_NUM_FRAMES;
+
+    while ((frame > 1) && (UVC_Frames[frame - 1].dwMaxVideoFrameSize > FrameQueue_MaxRoom()))
+        frame--;
+    return frame;
+}
+
+//Frame size of a negotiated bFormatIndex/bFrameIndex, both already range checked
+const UVC_FrameType* UVC_Stream_Frame(u8 format, u8 frame)
+{
+    if (format == VS_FORMAT_YUY2)
+        return &UVC_YuvFrames[frame - 1];
+    return &UVC_Frames[frame - 1];
+}
+
+//Write header + payload straight from frame memory into one PMA buffer
+//PMA holds one halfword per 32-bit word. The header is an even number of bytes and
+//packets start at even frame offsets, so the payload is read a word at a time and
+//split into two PMA halfwords, no staging buffer in between.
+static void UVC_WritePack(uint16_t wPMABufAddr, uint32_t hdrlen, const uint8_t* payload, uint32_t len)
+{
+    uint16_t *pma = (uint16_t *)(wPMABufAddr * 2 + PMAAddr);
+    const uint8_t *hdr = UVC_Header;
+    uint32_t i, w;
+
+    for (i = hdrlen; i != 0; i -= 2)
+    {
+        *pma = hdr[0] | (hdr[1] << 8);
+        pma += 2;
+        hdr += 2;
+    }
+
+    if (((uint32_t)payload & 1) == 0)
+    {
+        if (((uint32_t)payload & 2) && len >= 2)
+        {
+            *pma = *(const uint16_t *)payload;
+            pma += 2;
+            payload += 2;
+            len -= 2;
+        }
+        for (; len >= 8; len -= 8)
+        {
+            w = *(const uint32_t *)payload;
+            pma[0] = (uint16_t)w;
+            pma[2] = (uint16_t)(w >> 16);
+            w = *(const uint32_t *)(payload + 4);
+            pma[4] = (uint16_t)w;
+            pma[6] = (uint16_t)(w >> 16);
+            pma += 8;
+            payload += 8;
+        }
+    }
+    //tail, or a payload on an odd address
+    for (; len >= 2; len -= 2)
+    {
+        *pma = payload[0] | (payload[1] << 8);
+        pma += 2;
+        payload += 2;
+    }
+    if (len)
+        *pma = payload[0];
 }
@@ -1,9 +1,57 @@
 #ifndef 	_UVCSTREAM_H_
 #define		_UVCSTREAM_H_
 #include "at32f4xx.h"
+#include "usb_desc.h"
+#include "usb_conf.h"
+
+//streaming state, see UVC_Stream_Process()
+#define UVC_STATE_OFF           0
+#define UVC_STATE_READY         1
+#define UVC_STATE_NEED_FRAME    2
+#define UVC_STATE_BUSY          3
+
+//still image (method 2) state, see UVC_Still_Process()
+#define UVC_STILL_IDLE          0
+#define UVC_STILL_TRIGGER       1
+#define UVC_STILL_WAIT          2
+#define UVC_STILL_SENDING       3
+#define UVC_STILL_TIMEOUT       100         //UVC_Stream_Process() calls, about 1s from main loop
+
+//YUY2 capture, see UVC_YuvLine()
+//the sensor outputs UVC_YUV_DECIM times the frame height in 4:3, every UVC_YUV_DECIM-th
+//pixel and line is kept and the centre is cropped to the frame width (176 out of 192)
+#define UVC_YUV_DECIM           2
+#define UVC_YUV_FIFO_DEPTH      32          //output lines between the DVP DMA and EP1, power of 2
+
+//isochronous EP1 keeps the next packet written in the free PMA half, see UVC_SendPack_Irq()
+//a completion then only sets the count and the toggle, the copy follows it
+#define UVC_TX_PRESTAGE         1
+
+extern u16 UVC_PacketSize;
+extern volatile u8 UVC_State;
+extern volatile u32 UVC_FrameSentCnt;
+extern volatile u32 UVC_FrameRepeatCnt;
+extern volatile u32 UVC_EmptyPackCnt;
+extern volatile u32 UVC_YuvDropCnt;
+#if UVC_IRQ_HIST
+extern volatile u32 UVC_IrqHist[UVC_IRQ_HIST_BINS];
+extern volatile u32 UVC_IrqMax;
+#endif
 
 void UVC_SendPack_Irq(void);
-void bufCopy(u8* srcPtr,u8* desPtr, u32 len);
+void UVC_IrqHist_Add(u32 cycles);
+void UVC_Stream_Sof(void);
+void UVC_SetAltSetting(u8 alt);
+void UVC_Stream_Start(void);
+void UVC_Stream_Stop(void);
+void UVC_Stream_Commit(u8 format, u8 frame, u32 interval);
+void UVC_Still_Trigger(void);
+u8 UVC_Still_Busy(void);
+void UVC_Stream_Process(void);
+void UVC_Stream_Suspend(void);
+void UVC_Stream_Resume(void);
+u8 UVC_Stream_MaxFrame(void);
+const UVC_FrameType* UVC_Stream_Frame(u8 format, u8 frame);
 
 
 #endif
@@ -26,9 +26,12 @@
 #include "at32_board.h"
 
 #include "ov2640.h"
+#include "dvp.h"
+#include "frame_queue.h"
 
 #include "usb_istr.h"
 #include "usb_int.h"
+#include "uvcstream.h"
 
 
 /** @addtogroup AT32F403A_StdPeriph_Examples
@@ -132,6 +135,7 @@ void DebugMon_Handler(void)
   */
 void PendSV_Handler(void)
 {
+  FrameQueue_Process();
 }
 
 /**
@@ -212,55 +216,42 @@ void SysTick_Handler(void)
 
 void EXTI1_IRQHandler(void)
 {
+  uint8_t* buf;
+  uint32_t len,size;
 
-  if(OV2640_VSYNC == 1)
+  if(DVP_Mode == DVP_MODE_LINE)
   {
-    EXTI_Enable(EXTI2_IRQn);
-  }
-  else if(Frame_RcvLen != 0)
-  {
-    if(FrameBuf_1_Ready)  //ڽյbuf2
-    {
-      FrameBuf_1_Ready = 0;
-      FrameBuf_2_Len = Frame_RcvLen;
-      Frame_RcvPtr = FrameBuf_1_Addr;
-    }
+    if(OV2640_VSYNC == 1)
+      DVP_Line_Open();
     else
-    {
-//      EXTI_Disable(EXTI1_IRQn);
-      EXTI_Disable(EXTI2_IRQn);
-      EXTI_Disable(EXTI3_IRQn);
-      FrameBuf_1_Ready = 1;
-      FrameBuf_1_Len = Frame_RcvLen;
-      Frame_RcvPtr = FrameBuf_2_Addr;
-    }
-
-    Frame_RcvLen = 0;
-
+      DVP_Line_Close();
   }
-	EXTI_ClearIntPendingBit(EXTI_Line1);  ///<Clear the  EXTI line 0 pending bit
-}
-// trigger when line start
-void EXTI2_IRQHandler(void)
-{
-  if(OV2640_HREF == 1)
+  else if(OV2640_VSYNC == 1)
   {
-    EXTI_Enable(EXTI3_IRQn);
+    buf = FrameQueue_WriteBuf(&size);
+    if(buf)
+      DVP_Frame_Open(buf, size);
+    else
+      FrameQueue_Drop();    //USB is behind, skip this frame
   }
   else
   {
-    EXTI_Disable(EXTI3_IRQn);
+    len = DVP_Frame_Close();
+    if(len != 0)
+      FrameQueue_Push(len);
   }
-	EXTI_ClearIntPendingBit(EXTI_Line2);  ///<Clear the  EXTI line 0 pending bit
+	EXTI_ClearIntPendingBit(EXTI_Line1);  ///<Clear the  EXTI line 0 pending bit
 }
 
-// trigger byte line start
-void EXTI3_IRQHandler(void)
+/**
+  * @brief  This function handles DMA1 channel 7 interrupt request.
+  *         DVP line complete in DVP_MODE_LINE.
+  * @param  None
+  * @retval None
+  */
+void DMA1_Channel7_IRQHandler(void)
 {
-  *Frame_RcvPtr = OV2640_DATA;
-  Frame_RcvPtr++;
-  Frame_RcvLen++;
-	EXTI_ClearIntPendingBit(EXTI_Line3);  ///<Clear the  EXTI line 0 pending bit
+  DVP_Line_Irq();
 }
 
 /**
@@ -293,7 +284,13 @@ void EXTI3_IRQHandler(void)
   */
 void USB_HP_CAN1_TX_IRQHandler(void)
 {
+#if UVC_IRQ_HIST
+  uint32_t start = DWT->CYCCNT;
+#endif
   CTR_HP();
+#if UVC_IRQ_HIST
+  UVC_IrqHist_Add(DWT->CYCCNT - start);
+#endif
 }
 
 /**
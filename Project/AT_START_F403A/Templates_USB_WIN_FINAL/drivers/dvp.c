@@ -0,0 +1,275 @@
+#include "dvp.h"
+
+
+volatile uint32_t DVP_FrameCnt = 0;
+volatile uint32_t DVP_OverrunCnt = 0;
+volatile uint32_t DVP_JpegErrCnt = 0;
+volatile uint16_t DVP_LineCnt = 0;
+uint8_t DVP_Mode = DVP_MODE_FRAME;
+static uint32_t DVP_FrameSize = 0;   //TCNT loaded when the current frame was opened
+static uint8_t* DVP_FrameBuf;
+
+static uint8_t* DVP_LineBuf;         //two lines, ping-pong between DMA half and full transfer
+static uint16_t DVP_LineLen;
+static DVP_LineHandler DVP_LineCb;
+
+
+//DVP capture init
+//VSYNC EXTI1 is configured but left disabled in NVIC, call EXTI_Enable(EXTI1_IRQn)
+//once the sensor is running
+void DVP_Init(void)
+{
+	GPIO_InitType GPIO_InitStructure;
+	EXTI_InitType EXTI_InitStructure;
+	NVIC_InitType NVIC_InitStructure;
+	TMR_TimerBaseInitType TMR_TimeBaseStructure;
+	TMR_ICInitType TMR_ICInitStructure;
+	DMA_InitType DMA_InitStructure;
+
+	RCC_APB2PeriphClockCmd(RCC_APB2PERIPH_GPIOA|RCC_APB2PERIPH_GPIOD|RCC_APB2PERIPH_AFIO, ENABLE);
+	RCC_APB1PeriphClockCmd(DVP_PCLK_TMR_CLK, ENABLE);
+	RCC_AHBPeriphClockCmd(DVP_DMA_CLK, ENABLE);
+
+	//PA1 VSYNC, PA3 PCLK
+	GPIO_StructInit(&GPIO_InitStructure);
+	GPIO_InitStructure.GPIO_Pins = GPIO_Pins_1|GPIO_Pins_3;
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_PU;
+	GPIO_InitStructure.GPIO_MaxSpeed = GPIO_MaxSpeed_50MHz;
+	GPIO_Init(GPIOA, &GPIO_InitStructure);
+
+	//VSYNC: both edges, rising opens the frame, falling closes it
+	GPIO_EXTILineConfig(GPIO_PortSourceGPIOA, GPIO_PinsSource1);
+	EXTI_StructInit(&EXTI_InitStructure);
+	EXTI_InitStructure.EXTI_Line = EXTI_Line1;
+	EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
+	EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Rising_Falling;
+	EXTI_InitStructure.EXTI_LineEnable = ENABLE;
+	EXTI_Init(&EXTI_InitStructure);
+
+	NVIC_InitStructure.NVIC_IRQChannel = EXTI1_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 0x00;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0x00;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = DISABLE;
+	NVIC_Init(&NVIC_InitStructure);
+
+	//line complete, only raised in DVP_MODE_LINE
+	NVIC_InitStructure.NVIC_IRQChannel = DVP_DMA_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 0x00;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0x01;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+
+	//PCLK: free running counter, CH4 captures every rising edge
+	TMR_TimeBaseStructInit(&TMR_TimeBaseStructure);
+	TMR_TimeBaseStructure.TMR_DIV = 0;
+	TMR_TimeBaseStructure.TMR_CounterMode = TMR_CounterDIR_Up;
+	TMR_TimeBaseStructure.TMR_Period = 0xFFFF;
+	TMR_TimeBaseStructure.TMR_ClockDivision = TMR_CKD_DIV1;
+	TMR_TimeBaseInit(DVP_PCLK_TMR, &TMR_TimeBaseStructure);
+
+	TMR_ICStructInit(&TMR_ICInitStructure);
+	TMR_ICInitStructure.TMR_Channel = DVP_PCLK_TMR_CH;
+	TMR_ICInitStructure.TMR_ICPolarity = TMR_ICPolarity_Rising;
+	TMR_ICInitStructure.TMR_ICSelection = TMR_ICSelection_DirectTI;
+	TMR_ICInitStructure.TMR_ICDIV = TMR_ICDIV_DIV1;
+	TMR_ICInitStructure.TMR_ICFilter = 0x0;
+	TMR_ICInit(DVP_PCLK_TMR, &TMR_ICInitStructure);
+
+	//the DMA request stays off until DVP_Frame_Open()
+	TMR_DMACmd(DVP_PCLK_TMR, DVP_PCLK_TMR_DMA, DISABLE);
+	TMR_Cmd(DVP_PCLK_TMR, ENABLE);
+
+	//GPIOD input byte -> memory
+	DMA_Reset(DVP_DMA_CH);
+	DMA_DefaultInitParaConfig(&DMA_InitStructure);
+	DMA_InitStructure.DMA_PeripheralBaseAddr = DVP_DATA_ADDR;
+	DMA_InitStructure.DMA_MemoryBaseAddr = 0;
+	DMA_InitStructure.DMA_Direction = DMA_DIR_PERIPHERALSRC;
+	DMA_InitStructure.DMA_BufferSize = 0;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PERIPHERALINC_DISABLE;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MEMORYINC_ENABLE;
+	DMA_InitStructure.DMA_PeripheralDataWidth = DMA_PERIPHERALDATAWIDTH_BYTE;
+	DMA_InitStructure.DMA_MemoryDataWidth = DMA_MEMORYDATAWIDTH_BYTE;
+	DMA_InitStructure.DMA_Mode = DMA_MODE_NORMAL;
+	DMA_InitStructure.DMA_Priority = DMA_PRIORITY_VERYHIGH;
+	DMA_InitStructure.DMA_MTOM = DMA_MEMTOMEM_DISABLE;
+	DMA_Init(DVP_DMA_CH, &DMA_InitStructure);
+}
+
+//Start moving PCLK bytes into buf, called on VSYNC rising edge
+//size: room left in buf, clipped to DVP_DMA_MAX_LEN
+void DVP_Frame_Open(uint8_t* buf, uint32_t size)
+{
+	if(size > DVP_DMA_MAX_LEN)
+		size = DVP_DMA_MAX_LEN;
+
+	DVP_PCLK_TMR->DIE &= (uint16_t)(~DVP_PCLK_TMR_DMA);
+	DVP_DMA_CH->CHCTRL &= (uint16_t)(~DMA_CHCTRL1_CHEN);
+	DVP_DMA_CH->CMBA = (uint32_t)buf;
+	DVP_DMA_CH->TCNT = size;
+	DVP_FrameSize = size;
+	DVP_FrameBuf = buf;
+	//drop any edge latched before the frame, otherwise the first byte is garbage
+	DVP_PCLK_TMR->STS = (uint16_t)(~DVP_PCLK_TMR_FLAG);
+	DVP_DMA_CH->CHCTRL |= DMA_CHCTRL1_CHEN;
+	DVP_PCLK_TMR->DIE |= DVP_PCLK_TMR_DMA;
+}
+
+//Stop the transfer, called on VSYNC falling edge
+//The EOI search is left to DVP_JPEG_Len() outside the interrupt, this runs above the
+//USB interrupts and must not walk the frame
+//return: bytes the DMA wrote, EOI and sensor padding included, 0 if no frame was open
+//        or the buffer overflowed
+uint32_t DVP_Frame_Close(void)
+{
+	uint32_t left;
+	uint32_t size = DVP_FrameSize;
+
+	DVP_PCLK_TMR->DIE &= (uint16_t)(~DVP_PCLK_TMR_DMA);
+	left = DVP_DMA_CH->TCNT;
+	DVP_DMA_CH->CHCTRL &= (uint16_t)(~DMA_CHCTRL1_CHEN);
+	DVP_FrameSize = 0;
+
+	if(size == 0)
+		return 0;
+	DVP_FrameCnt++;
+	if(left == 0)		//buffer full, the tail of the frame is lost
+	{
+		DVP_OverrunCnt++;
+		return 0;
+	}
+	return size - left;
+}
+
+//Drop the frame or line being captured without counting it, VSYNC EXTI must already be off
+void DVP_Frame_Abort(void)
+{
+	DVP_PCLK_TMR->DIE &= (uint16_t)(~DVP_PCLK_TMR_DMA);
+	DVP_DMA_CH->CHCTRL &= (uint16_t)(~(DMA_CHCTRL1_CHEN | DMA_CHCTRL1_CIRM | DMA_CHCTRL1_HTIE | DMA_CHCTRL1_TCIE));
+	DMA_ClearFlag(DVP_DMA_FLAG_GL);
+	DVP_FrameSize = 0;
+}
+
+//Switch back to frame mode after DVP_Line_Config(), VSYNC EXTI must be off
+void DVP_Frame_Config(void)
+{
+	DVP_Frame_Abort();
+	DVP_Mode = DVP_MODE_FRAME;
+}
+
+//Find the end of a JPEG image, the sensor keeps clocking padding after EOI
+//buf must start with SOI (0xFF 0xD8), the sensor starts every frame with it
+//The header segments (DQT, DHT, SOF0 ...) are skipped by their length fields up to
+//the end of SOS, their tables may hold 0xFF 0xD9. In the entropy coded data 0xFF is
+//always stuffed as 0xFF 0x00, so EOI is searched backwards from the DMA end: only the
+//padding is walked, a word at a time while the words hold no 0xFF.
+//len: bytes the DMA wrote, see DVP_Frame_Close()
+//return: bytes up to and including EOI, 0 if SOI, SOS or EOI is missing
+uint32_t DVP_JPEG_Len(const uint8_t* buf, uint32_t len)
+{
+	uint32_t i = 2;
+	uint32_t j,w;
+	uint8_t marker;
+
+	if(len < 4 || buf[0] != 0xFF || buf[1] != 0xD8)
+		return 0;
+
+	//marker segments: 0xFF, marker, 16bit big endian length including itself
+	while(1)
+	{
+		if(i + 4 > len || buf[i] != 0xFF)
+			return 0;
+		marker = buf[i+1];
+		if(marker == 0xFF)			//fill byte
+		{
+			i++;
+			continue;
+		}
+		if(marker == 0xD9 || marker == 0xD8 || marker == 0x00)
+			return 0;
+		i += 2 + ((buf[i+2] << 8) | buf[i+3]);
+		if(marker == 0xDA)			//SOS, entropy coded data follows
+			break;
+	}
+
+	//an EOI at i..i+1 is the earliest one possible
+	for(j=len-2;j+1>i;j--)
+	{
+		if(((uint32_t)&buf[j] & 3) == 3 && j >= i + 3)
+		{
+			w = *(const uint32_t*)&buf[j-3];
+			//no byte of w is 0xFF, none of buf[j-3..j] starts an EOI
+			if(((~w - 0x01010101) & w & 0x80808080) == 0)
+			{
+				j -= 3;
+				continue;
+			}
+		}
+		if(buf[j] == 0xFF && buf[j+1] == 0xD9)
+			return j + 2;
+	}
+	return 0;
+}
+
+//Switch to line mode
+//buf: 2*line_len bytes, DMA fills one half while the handler reads the other
+//line_len: bytes per HREF window, ImageWidth*2 for YUV422/RGB565
+//handler: called once per line from the DMA interrupt
+void DVP_Line_Config(uint8_t* buf, uint16_t line_len, DVP_LineHandler handler)
+{
+	DVP_LineBuf = buf;
+	DVP_LineLen = line_len;
+	DVP_LineCb = handler;
+	DVP_Mode = DVP_MODE_LINE;
+}
+
+//Start line capture, called on VSYNC rising edge
+//PCLK only runs inside HREF, so every line is exactly DVP_LineLen bytes and the
+//circular DMA stays aligned: half transfer = even line done, full transfer = odd line done
+void DVP_Line_Open(void)
+{
+	DVP_PCLK_TMR->DIE &= (uint16_t)(~DVP_PCLK_TMR_DMA);
+	DVP_DMA_CH->CHCTRL &= (uint16_t)(~DMA_CHCTRL1_CHEN);
+	DMA_ClearFlag(DVP_DMA_FLAG_GL);
+	DVP_DMA_CH->CMBA = (uint32_t)DVP_LineBuf;
+	DVP_DMA_CH->TCNT = DVP_LineLen * 2;
+	DVP_DMA_CH->CHCTRL |= DMA_CHCTRL1_CIRM | DMA_CHCTRL1_HTIE | DMA_CHCTRL1_TCIE;
+	DVP_LineCnt = 0;
+	DVP_PCLK_TMR->STS = (uint16_t)(~DVP_PCLK_TMR_FLAG);
+	DVP_DMA_CH->CHCTRL |= DMA_CHCTRL1_CHEN;
+	DVP_PCLK_TMR->DIE |= DVP_PCLK_TMR_DMA;
+}
+
+//Stop line capture, called on VSYNC falling edge
+//return: lines received in the frame
+uint16_t DVP_Line_Close(void)
+{
+	DVP_PCLK_TMR->DIE &= (uint16_t)(~DVP_PCLK_TMR_DMA);
+	DVP_DMA_CH->CHCTRL &= (uint16_t)(~(DMA_CHCTRL1_CHEN | DMA_CHCTRL1_CIRM | DMA_CHCTRL1_HTIE | DMA_CHCTRL1_TCIE));
+	DMA_ClearFlag(DVP_DMA_FLAG_GL);
+	DVP_FrameCnt++;
+	return DVP_LineCnt;
+}
+
+//DMA half/full transfer interrupt in line mode
+void DVP_Line_Irq(void)
+{
+	uint8_t* line;
+
+	if(DMA_GetFlagStatus(DVP_DMA_FLAG_HT) != RESET)
+	{
+		DMA_ClearFlag(DVP_DMA_FLAG_HT);
+		line = DVP_LineBuf;
+	}
+	else if(DMA_GetFlagStatus(DVP_DMA_FLAG_TC) != RESET)
+	{
+		DMA_ClearFlag(DVP_DMA_FLAG_TC);
+		line = DVP_LineBuf + DVP_LineLen;
+	}
+	else
+		return;
+
+	if(DVP_LineCb)
+		DVP_LineCb(DVP_LineCnt, line, DVP_LineLen);
+	DVP_LineCnt++;
+}
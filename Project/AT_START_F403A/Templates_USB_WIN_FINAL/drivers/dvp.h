@@ -0,0 +1,57 @@
+#ifndef _DVP_H
+#define _DVP_H
+#include "sys.h"
+
+
+//DVP capture resources
+//PCLK(PA3) -> TMR2_CH4 input capture, every rising edge raises a CC4 DMA request
+//DMA1_Channel7 moves GPIOD->IPTDT[7:0] into the frame buffer, one byte per PCLK
+//VSYNC(PA1) -> EXTI1, opens and closes the transfer
+//HREF gating is done by the sensor: COM10[5] stops PCLK outside the HREF window
+#define DVP_PCLK_TMR          TMR2
+#define DVP_PCLK_TMR_CLK      RCC_APB1PERIPH_TMR2
+#define DVP_PCLK_TMR_CH       TMR_Channel_4
+#define DVP_PCLK_TMR_DMA      TMR_DMA_CC4
+#define DVP_PCLK_TMR_FLAG     TMR_FLAG_CC4
+#define DVP_DMA_CH            DMA1_Channel7
+#define DVP_DMA_CLK           RCC_AHBPERIPH_DMA1
+#define DVP_DATA_ADDR         ((uint32_t)&GPIOD->IPTDT)
+
+#define DVP_DMA_IRQn          DMA1_Channel7_IRQn
+#define DVP_DMA_FLAG_HT       DMA1_FLAG_HT7
+#define DVP_DMA_FLAG_TC       DMA1_FLAG_TC7
+#define DVP_DMA_FLAG_GL       DMA1_FLAG_GL7
+
+#define DVP_DMA_MAX_LEN       0xFFFF    //DMA TCNT is 16bit, one frame can not exceed it
+
+//capture mode
+#define DVP_MODE_FRAME        0         //JPEG: one DMA block per VSYNC window
+#define DVP_MODE_LINE         1         //YUV422/RGB565: one DMA block per HREF window
+
+
+//called from the DMA interrupt each time a line is complete
+//line: 0 based line index in the frame, buf: line data, len: bytes in the line
+//buf is reused two lines later, so it must be consumed before returning or copied
+typedef void (*DVP_LineHandler)(uint16_t line, uint8_t* buf, uint16_t len);
+
+
+extern volatile uint32_t DVP_FrameCnt;      //frames closed by VSYNC
+extern volatile uint32_t DVP_OverrunCnt;    //frames dropped because the buffer was full
+extern volatile uint32_t DVP_JpegErrCnt;    //frames dropped because SOI/EOI was missing
+extern volatile uint16_t DVP_LineCnt;       //lines completed in the current frame
+extern uint8_t DVP_Mode;
+
+
+void DVP_Init(void);
+void DVP_Frame_Open(uint8_t* buf, uint32_t size);
+uint32_t DVP_Frame_Close(void);
+void DVP_Frame_Abort(void);
+void DVP_Frame_Config(void);
+uint32_t DVP_JPEG_Len(const uint8_t* buf, uint32_t len);
+void DVP_Line_Config(uint8_t* buf, uint16_t line_len, DVP_LineHandler handler);
+void DVP_Line_Open(void);
+uint16_t DVP_Line_Close(void);
+void DVP_Line_Irq(void);
+
+
+#endif
@@ -0,0 +1,235 @@
+#include "frame_queue.h"
+#include "dvp.h"
+
+
+//RW_IRAM2 and RW_IRAM3 in Template.sct are UNINIT and only hold these sections, back to
+//back at the top of the default 96KB and the start of the extended 128KB
+#if defined(__CC_ARM)
+#define FRAME_ARENA_BASE_SECTION __attribute__((section("FRAME_ARENA_BASE"), zero_init, aligned(4)))
+#define FRAME_ARENA_EXT_SECTION  __attribute__((section("FRAME_ARENA_EXT"), zero_init, aligned(4)))
+#else
+#define FRAME_ARENA_BASE_SECTION __attribute__((section(".bss.FRAME_ARENA_BASE"), aligned(4)))
+#define FRAME_ARENA_EXT_SECTION  __attribute__((section(".bss.FRAME_ARENA_EXT"), aligned(4)))
+#endif
+
+static uint8_t FrameQueue_ArenaBase[FRAME_ARENA_BASE_SIZE] FRAME_ARENA_BASE_SECTION;
+static uint8_t FrameQueue_ArenaExt[FRAME_ARENA_EXT_SIZE] FRAME_ARENA_EXT_SECTION;
+static uint8_t* FrameQueue_Arena;
+static uint32_t FrameQueue_ArenaSize;
+static volatile uint32_t FrameQueue_MinRoom;   //no capture is started into less than this, largest expected frame
+static uint32_t FrameQueue_Depth;
+static uint32_t FrameQueue_Mask;
+uint8_t FrameQueue_ExtSRAM = 0;
+static uint8_t* volatile FrameQueue_WrPtr;     //end of the newest frame, producer and PendSV
+static uint8_t* volatile FrameQueue_WrBuf;     //start of the frame being captured
+static uint32_t FrameQueue_WrTime;             //DWT cycle count when it was handed out
+static uint8_t FrameQueue_WrTag;
+static volatile uint8_t FrameQueue_Tag = FRAME_TAG_VIDEO;
+static Frame_SlotType FrameQueue_Slot[FRAME_QUEUE_DEPTH_MAX];
+static volatile uint32_t FrameQueue_Closed = 0; //next slot to fill, producer only
+static volatile uint32_t FrameQueue_Head = 0;   //next slot to trim, PendSV only
+static volatile uint32_t FrameQueue_Tail = 0;   //next slot to send, consumer only
+static uint32_t FrameQueue_Seq = 0;
+volatile uint32_t FrameQueue_DropCnt = 0;
+
+
+//Pick the arena from the SRAM size, reset the queue and start the DWT cycle counter
+//used for time stamps. PendSV runs FrameQueue_Process() below every interrupt.
+void FrameQueue_Init(void)
+{
+	if(((UOPTB->EOPB0)&0xFF) == SRAM_EXT_EOPB0)
+	{
+		FrameQueue_ExtSRAM = 1;
+		FrameQueue_MinRoom = FRAME_ARENA_EXT_ROOM;
+		if((uint32_t)FrameQueue_ArenaBase + FRAME_ARENA_BASE_SIZE == (uint32_t)FrameQueue_ArenaExt)
+		{
+			//placed by Template.sct, the two arenas make one ring
+			FrameQueue_Arena = FrameQueue_ArenaBase;
+			FrameQueue_ArenaSize = FRAME_ARENA_BASE_SIZE + FRAME_ARENA_EXT_SIZE;
+			FrameQueue_Depth = FRAME_ARENA_JOIN_DEPTH;
+		}
+		else
+		{
+			FrameQueue_Arena = FrameQueue_ArenaExt;
+			FrameQueue_ArenaSize = FRAME_ARENA_EXT_SIZE;
+			FrameQueue_Depth = FRAME_ARENA_EXT_DEPTH;
+		}
+	}
+	else
+	{
+		FrameQueue_ExtSRAM = 0;
+		FrameQueue_Arena = FrameQueue_ArenaBase;
+		FrameQueue_ArenaSize = FRAME_ARENA_BASE_SIZE;
+		FrameQueue_MinRoom = FRAME_ARENA_BASE_ROOM;
+		FrameQueue_Depth = FRAME_ARENA_BASE_DEPTH;
+	}
+	FrameQueue_Mask = FrameQueue_Depth - 1;
+	FrameQueue_DropCnt = 0;
+	FrameQueue_Flush();
+	NVIC_SetPriority(PendSV_IRQn, (1 << __NVIC_PRIO_BITS) - 1);
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+//Throw away every queued frame, capture and USB streaming must both be stopped
+void FrameQueue_Flush(void)
+{
+	uint32_t i;
+
+	for(i=0;i<FRAME_QUEUE_DEPTH_MAX;i++)
+	{
+		FrameQueue_Slot[i].buf = FrameQueue_Arena;
+		FrameQueue_Slot[i].len = 0;
+	}
+	//slot tail-1 is the one held by the consumer, an empty frame at the arena start for now
+	FrameQueue_WrPtr = FrameQueue_Arena;
+	FrameQueue_WrBuf = FrameQueue_Arena;
+	FrameQueue_Closed = 0;
+	FrameQueue_Head = 0;
+	FrameQueue_Tail = 0;
+	FrameQueue_Seq = 0;
+}
+
+//Producer: largest contiguous free space in the arena for the next frame
+//Everything from the held slot (tail-1) up to FrameQueue_WrPtr is in use, the rest of
+//the ring is free. A word is kept between the write end and the oldest frame so a
+//full arena never looks empty.
+//size: returns the bytes that may be written
+//return: 0 if no slot is free or less than FrameQueue_MinRoom is left
+uint8_t* FrameQueue_WriteBuf(uint32_t* size)
+{
+	uint32_t tail = FrameQueue_Tail;
+	uint8_t* rd;
+	uint8_t* wr = FrameQueue_WrPtr;
+	uint8_t* end = FrameQueue_Arena + FrameQueue_ArenaSize;
+	uint32_t room;
+
+	if(FrameQueue_Closed - tail >= FrameQueue_Depth - 1)
+		return 0;
+	rd = FrameQueue_Slot[(tail - 1) & FrameQueue_Mask].buf;
+
+	if(wr >= rd)
+	{
+		room = end - wr;
+		if(room < FrameQueue_MinRoom)		//too little left at the end, wrap to the start
+		{
+			wr = FrameQueue_Arena;
+			room = (rd - wr > 4) ? (rd - wr - 4) : 0;
+		}
+	}
+	else
+		room = rd - wr - 4;
+
+	if(room < FrameQueue_MinRoom)
+		return 0;
+	FrameQueue_WrBuf = wr;
+	FrameQueue_WrTime = DWT->CYCCNT;
+	FrameQueue_WrTag = FrameQueue_Tag;
+	*size = room;
+	return wr;
+}
+
+//Producer: close the capture written into FrameQueue_WriteBuf()
+//len: bytes written, all of them stay reserved until FrameQueue_Process() trims the frame
+void FrameQueue_Push(uint32_t len)
+{
+	Frame_SlotType* slot = &FrameQueue_Slot[FrameQueue_Closed & FrameQueue_Mask];
+
+	slot->buf = FrameQueue_WrBuf;
+	slot->len = len;
+	slot->seq = FrameQueue_Seq++;
+	slot->time = FrameQueue_WrTime;
+	slot->tag = FrameQueue_WrTag;
+	FrameQueue_WrPtr = FrameQueue_WrBuf + ((len + 3) & ~3u);
+	__DMB();				//slot must be visible before FrameQueue_Process() sees it
+	FrameQueue_Closed++;
+	SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;	//trim it once no other interrupt is running
+}
+
+//PendSV: cut the closed captures at EOI and hand them to the consumer
+//A capture without a complete JPEG is passed on with len 0 so the slot order is kept,
+//the consumer skips it
+//The bytes after EOI go back to the arena when the frame is still the newest one and
+//no later capture was handed out behind it, older frames keep their tail until released
+void FrameQueue_Process(void)
+{
+	Frame_SlotType* slot;
+	uint32_t head = FrameQueue_Head;
+	uint32_t len;
+
+	while(head != FrameQueue_Closed)
+	{
+		slot = &FrameQueue_Slot[head & FrameQueue_Mask];
+		len = DVP_JPEG_Len(slot->buf, slot->len);
+		if(len == 0)
+			DVP_JpegErrCnt++;
+		__disable_irq();
+		if((head + 1 == FrameQueue_Closed) && (FrameQueue_WrBuf == slot->buf))
+			FrameQueue_WrPtr = slot->buf + ((len + 3) & ~3u);
+		__enable_irq();
+		slot->len = len;
+		head++;
+		__DMB();			//len must be visible before the consumer sees the new head
+		FrameQueue_Head = head;
+	}
+}
+
+//Producer: a frame was skipped, keep the sequence numbers counting
+void FrameQueue_Drop(void)
+{
+	FrameQueue_Seq++;
+	FrameQueue_DropCnt++;
+}
+
+//Consumer: take the oldest frame, the previous one is released
+//return: 0 if no new frame is waiting, keep using the previous one
+Frame_SlotType* FrameQueue_Pop(void)
+{
+	Frame_SlotType* slot;
+
+	if(FrameQueue_Tail == FrameQueue_Head)
+		return 0;
+	slot = &FrameQueue_Slot[FrameQueue_Tail & FrameQueue_Mask];
+	__DMB();
+	FrameQueue_Tail++;
+	return slot;
+}
+
+//frames waiting to be sent
+uint32_t FrameQueue_Count(void)
+{
+	return FrameQueue_Head - FrameQueue_Tail;
+}
+
+//Resize the room kept for each capture to the largest frame expected at the current
+//sensor size. May be called while capturing, the next FrameQueue_WriteBuf() uses it.
+//room: bytes, clipped to FrameQueue_MaxRoom()
+void FrameQueue_SetRoom(uint32_t room)
+{
+	if(room > FrameQueue_MaxRoom())
+		room = FrameQueue_MaxRoom();
+	FrameQueue_MinRoom = room;
+}
+
+//Largest room the arena can give while the consumer holds a frame of the same size
+uint32_t FrameQueue_MaxRoom(void)
+{
+	return FrameQueue_ArenaSize/2 - 4;
+}
+
+//Tag the frames captured from the next VSYNC on, call after the sensor is reconfigured
+void FrameQueue_SetTag(uint8_t tag)
+{
+	FrameQueue_Tag = tag;
+}
+
+//The whole arena, for a capture that does not go through the queue (DVP line mode)
+//Only valid while nothing is queued, FrameQueue_Flush() before using the queue again
+//size: returns the arena size
+uint8_t* FrameQueue_RawBuf(uint32_t* size)
+{
+	*size = FrameQueue_ArenaSize;
+	return FrameQueue_Arena;
+}
@@ -0,0 +1,64 @@
+#ifndef _FRAME_QUEUE_H
+#define _FRAME_QUEUE_H
+#include "sys.h"
+
+
+//Captured frame queue, single producer (VSYNC EXTI) / single consumer (USB EP1 IN)
+//A closed capture pends PendSV, FrameQueue_Process() runs there at the lowest priority,
+//trims it at EOI and only then moves head, so the JPEG scan never holds off VSYNC, DMA
+//or USB and does not wait for the main loop either
+//closed is only written by the producer, head by FrameQueue_Process() and tail by the
+//consumer, no locking needed
+//The slot handed out by FrameQueue_Pop() stays owned by the consumer until the next
+//Pop, so one slot is always kept back and at most depth-1 frames wait
+//Frame data is packed back to back in one ring (the arena), each frame only takes
+//its real length rounded up to a word
+//MDK_v5/Objects/Template.sct puts the 48KB base arena at the top of the default 96KB
+//and the 128KB extended arena right after it at 0x20018000. With EOPB0 = 0xFE (224KB
+//SRAM, see Examples/SRAM/extend_SRAM) both make one 176KB ring, otherwise only the base
+//arena is used. The choice is made at run time, a link that does not keep the two
+//arenas adjacent falls back to the extended one alone.
+#define SRAM_EXT_EOPB0         0xFE              //EOPB0 value selecting 224KB SRAM
+#define FRAME_ARENA_BASE_SIZE  (48*1024)         //0x2000C000 - 0x20017FFF
+#define FRAME_ARENA_BASE_ROOM  (20*1024)         //QVGA JPEG, default until FrameQueue_SetRoom()
+#define FRAME_ARENA_BASE_DEPTH 8
+#define FRAME_ARENA_EXT_SIZE   (128*1024)        //0x20018000 - 0x20037FFF
+#define FRAME_ARENA_EXT_ROOM   (20*1024)         //QVGA JPEG, default until FrameQueue_SetRoom()
+#define FRAME_ARENA_EXT_DEPTH  16
+#define FRAME_ARENA_JOIN_DEPTH 32                //base and extended arena as one ring
+#define FRAME_QUEUE_DEPTH_MAX  32                //depths must be powers of 2
+
+//Frame_SlotType.tag, which sensor configuration a frame was captured with
+#define FRAME_TAG_VIDEO        0
+#define FRAME_TAG_STILL        1
+
+
+typedef struct
+{
+	uint8_t* buf;
+	uint32_t len;     //exact JPEG length, 0 for a capture without a complete JPEG
+	uint32_t seq;     //capture sequence number, gaps mean dropped frames
+	uint32_t time;    //DWT cycle count at VSYNC open, start of capture (UVC PTS)
+	uint8_t tag;      //FrameQueue_SetTag() value when the capture started
+} Frame_SlotType;
+
+
+extern volatile uint32_t FrameQueue_DropCnt;   //frames not captured because the queue was full
+extern uint8_t FrameQueue_ExtSRAM;             //1: running from the 128KB extended SRAM arena
+
+
+void FrameQueue_Init(void);
+void FrameQueue_Flush(void);
+uint8_t* FrameQueue_WriteBuf(uint32_t* size);
+void FrameQueue_Push(uint32_t len);
+void FrameQueue_Process(void);
+void FrameQueue_Drop(void);
+Frame_SlotType* FrameQueue_Pop(void);
+uint32_t FrameQueue_Count(void);
+void FrameQueue_SetRoom(uint32_t room);
+uint32_t FrameQueue_MaxRoom(void);
+void FrameQueue_SetTag(uint8_t tag);
+uint8_t* FrameQueue_RawBuf(uint32_t* size);
+
+
+#endif
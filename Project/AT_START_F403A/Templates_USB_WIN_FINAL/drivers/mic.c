@@ -0,0 +1,141 @@
+#include "mic.h"
+
+
+volatile uint32_t MIC_OverrunCnt = 0;
+static int16_t MIC_Buf[MIC_RING_FRAMES*2];     //left, right, left, ...
+static uint16_t MIC_RdPos = 0;                 //next frame to read
+static uint32_t MIC_RdTime;                    //DWT cycle count at the last read
+static uint16_t MIC_RdLeft;                    //frames left unread by the last read
+
+
+//I2S3 slave receive and its DMA ring, left stopped until MIC_Start()
+void MIC_Init(void)
+{
+	GPIO_InitType GPIO_InitStructure;
+	I2S_InitType I2S_InitStructure;
+	DMA_InitType DMA_InitStructure;
+
+	RCC_APB2PeriphClockCmd(RCC_APB2PERIPH_GPIOA|RCC_APB2PERIPH_GPIOB|RCC_APB2PERIPH_AFIO, ENABLE);
+	RCC_APB1PeriphClockCmd(MIC_I2S_CLK, ENABLE);
+	RCC_AHBPeriphClockCmd(MIC_DMA_CLK, ENABLE);
+
+	//free PA15/PB3 from JTAG, SWD stays on PA13/PA14
+	GPIO_PinsRemapConfig(GPIO_Remap_SWJ_JTAGDisable, ENABLE);
+
+	//PA15 WS, PB3 CK, PB5 SD, all inputs in slave receive
+	GPIO_StructInit(&GPIO_InitStructure);
+	GPIO_InitStructure.GPIO_Pins = GPIO_Pins_15;
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_FLOATING;
+	GPIO_InitStructure.GPIO_MaxSpeed = GPIO_MaxSpeed_50MHz;
+	GPIO_Init(GPIOA, &GPIO_InitStructure);
+	GPIO_InitStructure.GPIO_Pins = GPIO_Pins_3|GPIO_Pins_5;
+	GPIO_Init(GPIOB, &GPIO_InitStructure);
+
+	SPI_I2S_Reset(MIC_I2S);
+	I2S_DefaultInit(&I2S_InitStructure);
+	I2S_InitStructure.I2S_Mode = I2S_MODE_SLAVERX;
+	I2S_InitStructure.I2s_AudioProtocol = I2S_AUDIOPROTOCOL_PHILLIPS;
+	I2S_InitStructure.I2S_FrameFormat = I2S_FRAMEFORMAT_DL16BIT_CHL16BIT;
+	I2S_InitStructure.I2S_MCLKOE = I2S_MCLKOE_DISABLE;
+	I2S_InitStructure.I2S_AudioFreq = I2S_AUDIOFREQ_16K;
+	I2S_InitStructure.I2S_CPOL = I2S_CPOL_LOW;
+	I2S_Init(MIC_I2S, &I2S_InitStructure);
+	SPI_I2S_DMAEnable(MIC_I2S, SPI_I2S_DMA_RX, ENABLE);
+
+	//I2S data register -> ring, one halfword per channel
+	DMA_Reset(MIC_DMA_CH);
+	DMA_DefaultInitParaConfig(&DMA_InitStructure);
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&MIC_I2S->DT;
+	DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)MIC_Buf;
+	DMA_InitStructure.DMA_Direction = DMA_DIR_PERIPHERALSRC;
+	DMA_InitStructure.DMA_BufferSize = MIC_RING_FRAMES*2;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PERIPHERALINC_DISABLE;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MEMORYINC_ENABLE;
+	DMA_InitStructure.DMA_PeripheralDataWidth = DMA_PERIPHERALDATAWIDTH_HALFWORD;
+	DMA_InitStructure.DMA_MemoryDataWidth = DMA_MEMORYDATAWIDTH_HALFWORD;
+	DMA_InitStructure.DMA_Mode = DMA_MODE_CIRCULAR;
+	DMA_InitStructure.DMA_Priority = DMA_PRIORITY_HIGH;
+	DMA_InitStructure.DMA_MTOM = DMA_MEMTOMEM_DISABLE;
+	DMA_Init(MIC_DMA_CH, &DMA_InitStructure);
+}
+
+//frame the DMA is writing, a half written frame is not counted
+static uint16_t MIC_WrPos(void)
+{
+	return (uint16_t)((MIC_RING_FRAMES*2 - MIC_DMA_CH->TCNT) >> 1) & (MIC_RING_FRAMES-1);
+}
+
+//Start the ring from frame 0 with the left channel first
+//a slave started in the middle of a word swaps the channels, so enable while WS is
+//high (right word) and reception starts at the next left word
+//return: 0 ok, 1 WS never toggled
+uint8_t MIC_Start(void)
+{
+	uint32_t t;
+
+	MIC_Stop();
+	(void)MIC_I2S->DT;		//a word left from the last run would shift the channels
+	DMA_ChannelEnable(MIC_DMA_CH, DISABLE);
+	MIC_DMA_CH->CMBA = (uint32_t)MIC_Buf;
+	MIC_DMA_CH->TCNT = MIC_RING_FRAMES*2;
+	MIC_RdPos = 0;
+	MIC_RdTime = DWT->CYCCNT;
+	MIC_RdLeft = 0;
+	DMA_ClearFlag(MIC_DMA_TC);
+	DMA_ChannelEnable(MIC_DMA_CH, ENABLE);
+
+	for(t=MIC_SYNC_TIMEOUT;t!=0 && GPIO_ReadInputDataBit(GPIOA, GPIO_Pins_15);t--);
+	for(;t!=0 && !GPIO_ReadInputDataBit(GPIOA, GPIO_Pins_15);t--);
+	if(t == 0)
+		return 1;
+	I2S_Enable(MIC_I2S, ENABLE);
+	return 0;
+}
+
+void MIC_Stop(void)
+{
+	I2S_Enable(MIC_I2S, DISABLE);
+	DMA_ChannelEnable(MIC_DMA_CH, DISABLE);
+}
+
+//frames captured and not read yet
+uint16_t MIC_Level(void)
+{
+	return (MIC_WrPos() - MIC_RdPos) & (MIC_RING_FRAMES-1);
+}
+
+//Copy the left channel of the next n frames to dst, the microphone is mono
+//TCNT only tells where the DMA is in the ring, not how often it went round. The frames
+//waiting are also estimated from the time since the last read, when that is more than
+//half a ring above the level the DMA lapped the reader and it is put back to
+//MIC_LEVEL_TARGET. The wrap flag keeps a stopped codec from looking like a lap.
+//return: frames copied, less than n when the ring holds fewer
+uint16_t MIC_Read(int16_t* dst, uint16_t n)
+{
+	uint16_t i, pos;
+	uint16_t level = MIC_Level();
+	uint32_t now = DWT->CYCCNT;
+	uint32_t age;
+
+	age = MIC_RdLeft + (now - MIC_RdTime) / (SystemCoreClock / MIC_SAMPLE_RATE);
+	if(DMA_GetFlagStatus(MIC_DMA_TC) == SET && age > level + MIC_RING_FRAMES/2)
+	{
+		MIC_OverrunCnt++;
+		MIC_RdPos = (MIC_WrPos() - MIC_LEVEL_TARGET) & (MIC_RING_FRAMES-1);
+		level = MIC_LEVEL_TARGET;
+	}
+	DMA_ClearFlag(MIC_DMA_TC);
+
+	pos = MIC_RdPos;
+	if(n > level)
+		n = level;
+	for(i=0;i<n;i++)
+	{
+		*dst++ = MIC_Buf[pos*2];
+		pos = (pos+1) & (MIC_RING_FRAMES-1);
+	}
+	MIC_RdPos = pos;
+	MIC_RdTime = now;
+	MIC_RdLeft = level - n;
+	return n;
+}
@@ -0,0 +1,33 @@
+#ifndef _MIC_H
+#define _MIC_H
+#include "sys.h"
+
+
+//microphone capture resources
+//the WM8988 is the I2S master, I2S3 receives as slave on its default pins:
+//LRCK(PA15) -> I2S3_WS, BCLK(PB3) -> I2S3_CK, ADCDAT(PB5) -> I2S3_SD
+//PA15/PB3 are JTAG pins, JTAG is switched off and SWD is kept
+//DMA2_Channel1 runs circular over MIC_Buf, the reader follows TCNT so no interrupt is used
+#define MIC_I2S               SPI3
+#define MIC_I2S_CLK           RCC_APB1PERIPH_SPI3
+#define MIC_DMA_CH            DMA2_Channel1
+#define MIC_DMA_CLK           RCC_AHBPERIPH_DMA2
+#define MIC_DMA_TC            DMA2_FLAG_TC1   //set each time the DMA wraps the ring
+
+#define MIC_RING_FRAMES       128       //stereo frames in the ring, 8ms at 16kHz, power of 2
+#define MIC_SAMPLE_RATE       16000
+#define MIC_LEVEL_TARGET      (MIC_RING_FRAMES/2)   //where a resync puts the reader behind the DMA
+#define MIC_SYNC_TIMEOUT      10000     //WS polls before giving up when the codec is not clocking
+
+
+extern volatile uint32_t MIC_OverrunCnt;   //reads that found the ring overwritten, the reader was resynced
+
+
+void MIC_Init(void);
+uint8_t MIC_Start(void);
+void MIC_Stop(void);
+uint16_t MIC_Level(void);
+uint16_t MIC_Read(int16_t* dst, uint16_t n);
+
+
+#endif
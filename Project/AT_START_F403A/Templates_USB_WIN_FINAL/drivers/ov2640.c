@@ -1,5 +1,6 @@
 #include "ov2640.h"
 #include "ov2640cfg.h"
+#include "frame_queue.h"
 
 //void JTAG_Set(uint8_t mode)
 //{
@@ -131,10 +132,16 @@ void OV2640_RGB565_Mode(void)
 		SCCB_WR_Reg(ov2640_rgb565_reg_tbl[i][0],ov2640_rgb565_reg_tbl[i][1]);
 	}
 }
+//OV2640лΪYUV422ģʽ, ֽ˳Y0 U0 Y1 V0, UVCYUY2
+//OV2640_JPEG_Mode()лJPEG
 void OV2640_YUV422_Mode(void)
 {
 	SCCB_WR_Reg(0xFF, 0x00);
-	SCCB_WR_Reg(0xDA, 0x01);
+	SCCB_WR_Reg(0xE0, 0x04);		//ʽлڼ临λDVP
+	SCCB_WR_Reg(0xDA, 0x00);		//YUV422, رJPEG, Yǰ
+	SCCB_WR_Reg(0xD7, 0x03);
+	SCCB_WR_Reg(0xE1, 0x77);
+	SCCB_WR_Reg(0xE0, 0x00);
 }
 //Զعò,֧5ȼ
 const static uint8_t OV2640_AUTOEXPOSURE_LEVEL[5][8]=
@@ -455,17 +462,8 @@ uint8_t OV2640_ImageSize_Set(uint16_t width,uint16_t height)
 }
 
 
-uint8_t  ov2640_framebuf1[40*1024];				//֡
-uint8_t* FrameBuf_1_Addr = &ov2640_framebuf1[0];
-uint8_t  ov2640_framebuf2[40*1024];				//֡
-uint8_t* FrameBuf_2_Addr = &ov2640_framebuf2[0];
 uint8_t* Frame_SendPtr;
-uint8_t* Frame_RcvPtr;
-uint8_t  FrameBuf_1_Ready = 0;
-uint32_t FrameBuf_1_Len = 0;
-uint32_t FrameBuf_2_Len = 0;
 uint32_t FrameLen = 0;
-uint32_t Frame_RcvLen = 0;
 
 //OV2640ٶȿ
 //LCDֱʵĲͬòͬĲ
@@ -484,10 +482,13 @@ void ov2640_speed_ctrl(void)
 //	SCCB_WR_Reg(0XFF,0X01);
 //	SCCB_WR_Reg(0X11,0X0);  //Լ15֡ÿ
 
-	SCCB_WR_Reg(0XFF,0X00);
-	SCCB_WR_Reg(0XD3,15);
-	SCCB_WR_Reg(0XFF,0X01);
-	SCCB_WR_Reg(0X11,0X02);   //Լ7֡ÿ
+//	SCCB_WR_Reg(0XFF,0X00);
+//	SCCB_WR_Reg(0XD3,15);
+//	SCCB_WR_Reg(0XFF,0X01);
+//	SCCB_WR_Reg(0X11,0X02);   //Լ7֡ÿ
+
+	//DMA capture (dvp.c): PCLK = 48MHz/12 = 4MHz, about 15fps at QVGA JPEG
+	ov2640_speed_set(0X00,OV2640_PCLK_DIV_MIN);
 
 //	SCCB_WR_Reg(0XFF,0X00);
 //	SCCB_WR_Reg(0XD3,18);	//PCLKƵ
@@ -499,6 +500,19 @@ void ov2640_speed_ctrl(void)
 //	SCCB_WR_Reg(0XFF,0X01);
 //	SCCB_WR_Reg(0X11,3);	//CLKƵ
 }
+//OV2640֡
+//clkrc: CLKRC(0x11), ڲʱ = XVCLK/(clkrc+1), ֮֡
+//pclkdiv: R_DVP_SP(0xD3), PCLK = 48MHz/pclkdiv, СOV2640_PCLK_DIV_MIN
+void ov2640_speed_set(uint8_t clkrc,uint8_t pclkdiv)
+{
+	if(pclkdiv<OV2640_PCLK_DIV_MIN)
+		pclkdiv=OV2640_PCLK_DIV_MIN;
+	SCCB_WR_Reg(0XFF,0X00);
+	SCCB_WR_Reg(0XD3,pclkdiv&0X7F);
+	SCCB_WR_Reg(0XFF,0X01);
+	SCCB_WR_Reg(0X11,clkrc);
+	SCCB_WR_Reg(OV2640_SENSOR_COM10,0X20);	//PCLK only toggles while HREF is high
+}
 //OV2640jpgͼƬ
 //ֵ:0,ɹ
 //    ,
@@ -509,8 +523,12 @@ uint8_t ov2640_jpg_photo()
 	uint8_t res=0;
 	uint32_t i=0,t=0,j=0,c;
 	uint8_t* pbuf;
-	uint32_t Len=0;
+	uint32_t Len=0,RcvLen=0,BufSize;
 	uint8_t s[4];
+	uint8_t* framebuf=FrameQueue_WriteBuf(&BufSize);	//borrow free arena space
+
+	if(framebuf==0)
+		return 2;
 
 	OV2640_JPEG_Mode();							//лΪJPEGģʽ
 //    OV2640_RGB565_Mode();
@@ -527,19 +545,22 @@ uint8_t ov2640_jpg_photo()
 	}
 //  while(1)
 //  {
-    FrameBuf_1_Len=0;
+    RcvLen=0;
     while(OV2640_VSYNC==1)	//ʼɼjpeg
     {
     	while(OV2640_HREF)
     	{
     		while(OV2640_PCLK==0);
-    		ov2640_framebuf1[FrameBuf_1_Len]=OV2640_DATA;
+    		if(RcvLen<BufSize)
+    			framebuf[RcvLen]=OV2640_DATA;
     		while(OV2640_PCLK==1);
-    		FrameBuf_1_Len++;
+    		RcvLen++;
     	}
     }
-    	pbuf=(uint8_t*)ov2640_framebuf1;
-    	for(i=0;i<FrameBuf_1_Len;i++)//0XFF,0XD8
+    	if(RcvLen>BufSize-1)
+    		RcvLen=BufSize-1;
+    	pbuf=framebuf;
+    	for(i=0;i<RcvLen;i++)//0XFF,0XD8
     	{
     		if((pbuf[i]==0XFF)&&(pbuf[i+1]==0XD8))//¼֡ͷλ
     		{
@@ -552,14 +573,13 @@ uint8_t ov2640_jpg_photo()
     		}
     	}
     	Len=j-t+1;
-    	if(i==FrameBuf_1_Len)
+    	if(i==RcvLen)
     	{
     		res=1;//ûҵ0XFF,0XD8
 
     	}
     	else		//ҵ
     	{
-        FrameBuf_1_Len = Len;
     		pbuf+=t;//ƫƵ0XFF,0XD8
     		s[0]=(uint8_t)(((Len)&0xff000000)>>24);
     		s[1]=(uint8_t)(((Len)&0xff0000)>>16);
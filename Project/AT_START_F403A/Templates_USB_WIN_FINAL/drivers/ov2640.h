@@ -15,18 +15,12 @@
 #define ImageWidth   320  //JPEGյĿ
 #define ImageHeight  240  //JPEGյĸ߶
 
+//R_DVP_SP, PCLK4MHz, DVP DMA
+#define OV2640_PCLK_DIV_MIN  12
+
 
-extern uint8_t ov2640_framebuf1[];				//֡
-extern uint8_t* FrameBuf_1_Addr;
-extern uint8_t ov2640_framebuf2[];				//֡
-extern uint8_t* FrameBuf_2_Addr;
 extern uint8_t* Frame_SendPtr;
-extern uint8_t* Frame_RcvPtr;
-extern uint8_t FrameBuf_1_Ready;
-extern uint32_t FrameBuf_1_Len;
-extern uint32_t FrameBuf_2_Len;
 extern uint32_t FrameLen;
-extern uint32_t Frame_RcvLen;
 
 
 #define ImageData(H, W) 		(*(u8*)(ImageBuf+H*ImageWidth+W))
@@ -142,6 +136,7 @@ uint8_t OV2640_OutSize_Set(uint16_t width,uint16_t height);
 uint8_t OV2640_ImageWin_Set(uint16_t offx,uint16_t offy,uint16_t width,uint16_t height);
 uint8_t OV2640_ImageSize_Set(uint16_t width,uint16_t height);
 void ov2640_speed_ctrl(void);
+void ov2640_speed_set(uint8_t clkrc,uint8_t pclkdiv);
 uint8_t ov2640_jpg_photo(void);
 void SendAChar(uint8_t date);
 void SendRAMDate(uint32_t Len,unsigned char *strp);
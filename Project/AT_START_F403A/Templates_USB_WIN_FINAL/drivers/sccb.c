@@ -105,10 +105,17 @@ uint8_t SCCB_RD_Byte(void)
 //дĴ
 //ֵ:0,ɹ;1,ʧ.
 uint8_t SCCB_WR_Reg(uint8_t reg,uint8_t data)
+{
+	return SCCB_WR_Dev(SCCB_ID, reg, data);
+}
+
+//Two byte write to another device on the bus, the WM8988 shares it with the sensor
+//Return: 0 ok, 1 no ACK
+uint8_t SCCB_WR_Dev(uint8_t id,uint8_t reg,uint8_t data)
 {
 	uint8_t res=0;
 	SCCB_Start(); 					//SCCB
-	if(SCCB_WR_Byte(SCCB_ID))res=1;	//дID
+	if(SCCB_WR_Byte(id))res=1;		//дID
 	Delay_us(100);
   	if(SCCB_WR_Byte(reg))res=1;		//дĴַ
 	Delay_us(100);
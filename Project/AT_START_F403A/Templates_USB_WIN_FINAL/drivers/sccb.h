@@ -21,6 +21,7 @@ void SCCB_No_Ack(void);
 uint8_t SCCB_WR_Byte(uint8_t dat);
 uint8_t SCCB_RD_Byte(void);
 uint8_t SCCB_WR_Reg(uint8_t reg,uint8_t data);
+uint8_t SCCB_WR_Dev(uint8_t id,uint8_t reg,uint8_t data);
 uint8_t SCCB_RD_Reg(uint8_t reg);
 #endif
 
@@ -0,0 +1,104 @@
+#include "wm8988.h"
+#include "sccb.h"
+
+
+//register values of the microphone path, written in this order after the reset
+static const uint16_t WM8988_MicCfg[][2]=
+{
+	{WM8988_R0_LINVOL,  0x12F},		//input PGA +17.25dB, update both
+	{WM8988_R1_RINVOL,  0x12F},
+	{WM8988_R7_IFACE,   0x042},		//master, I2S, 16bit
+	{WM8988_R8_SRATE,   0x095},		//USB mode, 12MHz MCLK, 16kHz ADC
+	{WM8988_R21_LADCVOL,WM8988_VOL_UPDATE|WM8988_ADC_VOL_0DB},
+	{WM8988_R22_RADCVOL,WM8988_VOL_UPDATE|WM8988_ADC_VOL_0DB},
+	{WM8988_R23_ADCTL1, 0x0C2},
+	{WM8988_R24_ADCTL2, 0x000},
+	{WM8988_R27_ADCTL3, 0x000},
+	{WM8988_R31_ADCIN,  0x000},		//ADC from the PGA, stereo
+	{WM8988_R32_LADCIN, 0x000},		//LINPUT1, no boost
+	{WM8988_R33_RADCIN, 0x000},
+	{WM8988_R26_PWR2,   0x000},		//DACs and outputs stay off
+	{WM8988_R25_PWR1,   WM8988_PWR1_MIC},
+};
+
+//12MHz MCLK on PA8, TMR1 counts at 24MHz and toggles every count
+static void WM8988_MCLK_Init(void)
+{
+	GPIO_InitType GPIO_InitStructure;
+	TMR_TimerBaseInitType TMR_TimeBaseStructure;
+	TMR_OCInitType TMR_OCInitStructure;
+
+	RCC_APB2PeriphClockCmd(RCC_APB2PERIPH_GPIOA|RCC_APB2PERIPH_TMR1, ENABLE);
+
+	GPIO_StructInit(&GPIO_InitStructure);
+	GPIO_InitStructure.GPIO_Pins = GPIO_Pins_8;
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
+	GPIO_InitStructure.GPIO_MaxSpeed = GPIO_MaxSpeed_50MHz;
+	GPIO_Init(GPIOA, &GPIO_InitStructure);
+
+	TMR_TimeBaseStructInit(&TMR_TimeBaseStructure);
+	TMR_TimeBaseStructure.TMR_DIV = (uint16_t)(SystemCoreClock / (WM8988_MCLK_FREQ * 2)) - 1;
+	TMR_TimeBaseStructure.TMR_CounterMode = TMR_CounterDIR_Up;
+	TMR_TimeBaseStructure.TMR_Period = 1;
+	TMR_TimeBaseStructure.TMR_ClockDivision = TMR_CKD_DIV1;
+	TMR_TimeBaseInit(TMR1, &TMR_TimeBaseStructure);
+
+	TMR_OCStructInit(&TMR_OCInitStructure);
+	TMR_OCInitStructure.TMR_OCMode = TMR_OCMode_PWM1;
+	TMR_OCInitStructure.TMR_OutputState = TMR_OutputState_Enable;
+	TMR_OCInitStructure.TMR_Pulse = 1;
+	TMR_OCInitStructure.TMR_OCPolarity = TMR_OCPolarity_High;
+	TMR_OC1Init(TMR1, &TMR_OCInitStructure);
+	TMR_OC1PreloadConfig(TMR1, TMR_OCPreload_Enable);
+
+	TMR_Cmd(TMR1, ENABLE);
+	TMR_CtrlPWMOutputs(TMR1, ENABLE);
+}
+
+//write one register, the 9th data bit rides in the address byte
+//return: 0 ok, 1 no ACK
+uint8_t WM8988_WR_Reg(uint8_t reg,uint16_t data)
+{
+	return SCCB_WR_Dev(WM8988_ID, (reg<<1)|((data>>8)&0x01), data&0xFF);
+}
+
+//start MCLK and bring up the microphone path, the codec starts driving BCLK/LRCK
+//SCCB_Init() must have been called (OV2640_Init() does it)
+//return: 0 ok, 1 the codec did not answer
+uint8_t WM8988_Init(void)
+{
+	uint8_t i;
+
+	WM8988_MCLK_Init();
+	if(WM8988_WR_Reg(WM8988_R15_RESET, 0))
+		return 1;
+	Delay_ms(10);
+	for(i=0;i<sizeof(WM8988_MicCfg)/sizeof(WM8988_MicCfg[0]);i++)
+	{
+		if(WM8988_WR_Reg(WM8988_MicCfg[i][0], WM8988_MicCfg[i][1]))
+			return 1;
+	}
+	return 0;
+}
+
+//ADC digital volume of both channels, vol: WM8988_ADC_VOL_MUTE..0xFF
+void WM8988_ADC_Volume(uint8_t vol)
+{
+	WM8988_WR_Reg(WM8988_R21_LADCVOL, vol);
+	WM8988_WR_Reg(WM8988_R22_RADCVOL, WM8988_VOL_UPDATE|vol);
+}
+
+//USB suspend: everything off including VMID, then MCLK stops
+//the other registers keep their values as long as the codec supply stays on
+void WM8988_PowerDown(void)
+{
+	WM8988_WR_Reg(WM8988_R25_PWR1, 0);
+	TMR_Cmd(TMR1, DISABLE);
+}
+
+//undo WM8988_PowerDown(), VMID needs some ms to settle so the first samples may click
+void WM8988_PowerUp(void)
+{
+	TMR_Cmd(TMR1, ENABLE);
+	WM8988_WR_Reg(WM8988_R25_PWR1, WM8988_PWR1_MIC);
+}
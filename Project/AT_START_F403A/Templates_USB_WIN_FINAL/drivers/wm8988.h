@@ -0,0 +1,45 @@
+#ifndef _WM8988_H
+#define _WM8988_H
+#include "sys.h"
+
+
+//WM8988 codec, only the ADC (microphone) path is used
+//control: 2-wire on the SCCB bus (PB9/PB12), the codec sits at 0x34 next to the OV2640
+//MCLK: TMR1_CH1(PA8) PWM at 12MHz, the codec runs in USB mode and is the I2S master
+#define WM8988_ID             0x34
+#define WM8988_MCLK_FREQ      12000000
+
+//register addresses, 7bit, the data field is 9bit
+#define WM8988_R0_LINVOL      0x00      //left input PGA
+#define WM8988_R1_RINVOL      0x01      //right input PGA
+#define WM8988_R5_ADCDAC      0x05
+#define WM8988_R7_IFACE       0x07      //audio interface format
+#define WM8988_R8_SRATE       0x08      //sample rate
+#define WM8988_R15_RESET      0x0F
+#define WM8988_R21_LADCVOL    0x15      //left ADC digital volume
+#define WM8988_R22_RADCVOL    0x16      //right ADC digital volume
+#define WM8988_R23_ADCTL1     0x17
+#define WM8988_R24_ADCTL2     0x18
+#define WM8988_R25_PWR1       0x19
+#define WM8988_R26_PWR2       0x1A
+#define WM8988_R27_ADCTL3     0x1B
+#define WM8988_R31_ADCIN      0x1F
+#define WM8988_R32_LADCIN     0x20
+#define WM8988_R33_RADCIN     0x21
+
+//ADC digital volume: 0xC3 is 0dB, 0.5dB per step, 0 is digital mute
+#define WM8988_ADC_VOL_0DB    0xC3
+#define WM8988_ADC_VOL_MUTE   0x00
+#define WM8988_VOL_UPDATE     0x100     //latches both channel volumes at once
+
+#define WM8988_PWR1_MIC       0x17C     //VMID 2x50k, VREF, input PGAs and ADCs on
+
+
+uint8_t WM8988_Init(void);
+uint8_t WM8988_WR_Reg(uint8_t reg,uint16_t data);
+void WM8988_ADC_Volume(uint8_t vol);
+void WM8988_PowerDown(void);
+void WM8988_PowerUp(void);
+
+
+#endif
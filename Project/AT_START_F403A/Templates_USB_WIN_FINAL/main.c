@@ -28,10 +28,15 @@
 #include "sys.h"
 
 #include "ov2640.h"
+#include "dvp.h"
+#include "frame_queue.h"
+#include "uvcstream.h"
+#include "uacstream.h"
 
 #include "usb_lib.h"
 #include "hw_config.h"
 #include "usb_pwr.h"
+#include "usb_bench.h"
 
 /** @addtogroup AT32F403A_StdPeriph_Examples
   * @{
@@ -45,15 +50,7 @@
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
-GPIO_InitType GPIO_InitStructure;
-EXTI_InitType EXTI_InitStructure;
-NVIC_InitType NVIC_InitStructure = {0};
-
 /* Private function prototypes -----------------------------------------------*/
-void EXTI1_Config(void);
-void EXTI2_Config(void);
-void EXTI3_Config(void);
-
 
 /* Private functions ---------------------------------------------------------*/
 
@@ -64,8 +61,9 @@ void EXTI3_Config(void);
  */
 int main(void)
 {
-	GPIO_StructInit(&GPIO_InitStructure);
-	EXTI_StructInit(&EXTI_InitStructure);
+  uint32_t led_cnt = 0;
+  uint32_t i;
+
   NVIC_PriorityGroupConfig(NVIC_PriorityGroup_2);
 	AT32_Board_Init();   ///<Initialize LED and KEY
 
@@ -80,117 +78,43 @@ int main(void)
 
 
   /*if use USB SRAM_Size = 768 Byte, default is 512 Byte*/
-//  Set_USB768ByteMode();
+  Set_USB768ByteMode();
   /* USB protocol and register initialize*/
   USB_Init();
+#if USB_MEM_BENCH
+  USB_MemBench_Run();
+#endif
 
-  EXTI1_Config();
-  EXTI2_Config();
-  EXTI3_Config();
+  DVP_Init();
 
   OV2640_Init();
 
-  Frame_RcvPtr = FrameBuf_1_Addr;
-  EXTI_Enable(EXTI1_IRQn);
-
-  while(FrameBuf_1_Ready == 0);
-  //ʹUSB
-  _SetEPTxStatus(ENDP1, EP_TX_VALID);
+  FrameQueue_Init();
+#if UAC_MIC_ENABLE
+  UAC_Init();         //after OV2640_Init(), the codec shares its SCCB bus
+#endif
+  //capture and EP1 are started by UVC_Stream_Process() when the host selects streaming
 
 	while (1)
 	{
-    AT32_LEDn_Toggle(LED4);
-    Delay_ms(500);
+    Suspend_Process();    //returns at once unless the host suspended the bus
+    UVC_Stream_Process();
+#if UAC_MIC_ENABLE
+    UAC_Stream_Process();
+#endif
+    //10ms in 1ms steps, STOP has to be reached within 7ms of the suspend interrupt
+    for(i = 0; (i < 10) && (bDeviceState != SUSPENDED); i++)
+    {
+      Delay_ms(1);
+    }
+    if(++led_cnt >= 50)
+    {
+      led_cnt = 0;
+      AT32_LEDn_Toggle(LED4);
+    }
 	}
 }
 
-/**
-  * @brief  EXTI0 Config.Configure PA0 in interrupt mode
-  * @param  None
-  * @retval None
-  */
-void EXTI1_Config(void)
-{
-	RCC_APB2PeriphClockCmd(RCC_APB2PERIPH_GPIOA, ENABLE);        ///<Enable GPIOA clock
-	GPIO_InitStructure.GPIO_Pins = GPIO_Pins_1;
- 	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_PU;
- 	GPIO_InitStructure.GPIO_MaxSpeed = GPIO_MaxSpeed_50MHz;
-	GPIO_Init(GPIOA, &GPIO_InitStructure);                       ///<Configure PA.00 pin as input floating
-
-	RCC_APB2PeriphClockCmd(RCC_APB2PERIPH_AFIO, ENABLE);         ///<Enable AFIO clock
-	GPIO_EXTILineConfig(GPIO_PortSourceGPIOA, GPIO_PinsSource1); ///<Connect EXTI0 Line to PA0 pin
-
-	EXTI_InitStructure.EXTI_Line = EXTI_Line1;
-	EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
-	EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Rising_Falling;
-	EXTI_InitStructure.EXTI_LineEnable = ENABLE;
-	EXTI_Init(&EXTI_InitStructure);                              ///<Configure EXTI0 line
-
-	NVIC_InitStructure.NVIC_IRQChannel = EXTI1_IRQn;
-	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 0x00;
-	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0x00;
-	NVIC_InitStructure.NVIC_IRQChannelCmd = DISABLE;
-	NVIC_Init(&NVIC_InitStructure);                              ///<Enable and set EXTI0 Interrupt to the lowest priority
-}
-
-/**
-  * @brief  EXTI0 Config.Configure PA0 in interrupt mode
-  * @param  None
-  * @retval None
-  */
-void EXTI2_Config(void)
-{
-	RCC_APB2PeriphClockCmd(RCC_APB2PERIPH_GPIOA, ENABLE);        ///<Enable GPIOA clock
-	GPIO_InitStructure.GPIO_Pins = GPIO_Pins_2;
- 	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_PU;
- 	GPIO_InitStructure.GPIO_MaxSpeed = GPIO_MaxSpeed_50MHz;
-	GPIO_Init(GPIOA, &GPIO_InitStructure);                       ///<Configure PA.00 pin as input floating
-
-	RCC_APB2PeriphClockCmd(RCC_APB2PERIPH_AFIO, ENABLE);         ///<Enable AFIO clock
-	GPIO_EXTILineConfig(GPIO_PortSourceGPIOA, GPIO_PinsSource2); ///<Connect EXTI0 Line to PA0 pin
-
-	EXTI_InitStructure.EXTI_Line = EXTI_Line2;
-	EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
-	EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Rising_Falling;
-	EXTI_InitStructure.EXTI_LineEnable = ENABLE;
-	EXTI_Init(&EXTI_InitStructure);                              ///<Configure EXTI0 line
-
-	NVIC_InitStructure.NVIC_IRQChannel = EXTI2_IRQn;
-	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 0x00;
-	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0x01;
-	NVIC_InitStructure.NVIC_IRQChannelCmd = DISABLE;
-	NVIC_Init(&NVIC_InitStructure);                              ///<Enable and set EXTI0 Interrupt to the lowest priority
-}
-
-/**
-  * @brief  EXTI0 Config.Configure PA0 in interrupt mode
-  * @param  None
-  * @retval None
-  */
-void EXTI3_Config(void)
-{
-	RCC_APB2PeriphClockCmd(RCC_APB2PERIPH_GPIOA, ENABLE);        ///<Enable GPIOA clock
-	GPIO_InitStructure.GPIO_Pins = GPIO_Pins_3;
- 	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_PU;
- 	GPIO_InitStructure.GPIO_MaxSpeed = GPIO_MaxSpeed_50MHz;
-	GPIO_Init(GPIOA, &GPIO_InitStructure);                       ///<Configure PA.00 pin as input floating
-
-	RCC_APB2PeriphClockCmd(RCC_APB2PERIPH_AFIO, ENABLE);         ///<Enable AFIO clock
-	GPIO_EXTILineConfig(GPIO_PortSourceGPIOA, GPIO_PinsSource3); ///<Connect EXTI0 Line to PA0 pin
-
-	EXTI_InitStructure.EXTI_Line = EXTI_Line3;
-	EXTI_InitStructure.EXTI_Mode = EXTI_Mode_Interrupt;
-	EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Rising;
-	EXTI_InitStructure.EXTI_LineEnable = ENABLE;
-	EXTI_Init(&EXTI_InitStructure);                              ///<Configure EXTI0 line
-
-	NVIC_InitStructure.NVIC_IRQChannel = EXTI3_IRQn;
-	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 0x00;
-	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0x02;
-	NVIC_InitStructure.NVIC_IRQChannelCmd = DISABLE;
-	NVIC_Init(&NVIC_InitStructure);                              ///<Enable and set EXTI0 Interrupt to the lowest priority
-}
-
 
 #ifdef  USE_FULL_ASSERT
 
@@ -0,0 +1,155 @@
+//Host test of the PMA copy routines in usb_mem.c against the bytewise ones they replaced
+//The PMA is simulated as on the chip: one halfword of packet memory in the low half of
+//every 32 bit word. The upper halves are filled with a pattern that must survive every
+//write and must never show up in what is read back.
+//Every buffer alignment (0..3), a few PMA addresses and every length that fits are run.
+//usb_mem.c is built as its own unit, stub/usb_lib.h gives it the simulated PMA base
+//Build and run from this directory:
+//  gcc -Wall -Wno-pointer-to-int-cast -Istub -I../../../../Middlewares/AT32_USB-FS-Device_Driver/inc -o pma_copy_test pma_copy_test.c ../../../../Middlewares/AT32_USB-FS-Device_Driver/src/usb_mem.c && ./pma_copy_test
+//return: 0 when all cases match
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "usb_lib.h"
+
+#define USB_PMA_SIZE        768
+#define PMA_WORDS           (USB_PMA_SIZE/2)
+#define PMA_HIGH_FILL       0xA5A50000u
+#define USR_FILL            0x5A
+#define USR_GUARD           8
+
+static uint32_t Pma[PMA_WORDS];
+static uint32_t PmaRef[PMA_WORDS];
+uintptr_t PMAAddr;                    //usb_mem.c addresses the PMA through this
+
+
+//the routines as they were before the fast paths, one halfword at a time
+//odd lengths: the write takes the byte after the buffer as the high half and the read
+//stores one byte past the buffer, the test only compares what the caller asked for
+static void Ref_UserToPMABufferCopy(uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes)
+{
+  uint32_t n = (wNBytes + 1) >> 1;
+  uint32_t i, temp1, temp2;
+  uint16_t *pdwVal;
+  pdwVal = (uint16_t *)(wPMABufAddr * 2 + (uintptr_t)PmaRef);
+  for (i = n; i != 0; i--)
+  {
+    temp1 = (uint16_t) * pbUsrBuf;
+    pbUsrBuf++;
+    temp2 = temp1 | (uint16_t) * pbUsrBuf << 8;
+    *pdwVal++ = temp2;
+    pdwVal++;
+    pbUsrBuf++;
+  }
+}
+
+static void Ref_PMAToUserBufferCopy(uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes)
+{
+  uint32_t n = (wNBytes + 1) >> 1;
+  uint32_t i;
+  uint32_t *pdwVal;
+  pdwVal = (uint32_t *)(wPMABufAddr * 2 + (uintptr_t)PmaRef);
+  for (i = n; i != 0; i--)
+  {
+    *pbUsrBuf++ = (uint8_t)*pdwVal;
+    *pbUsrBuf++ = (uint8_t)(*pdwVal++ >> 8);
+  }
+}
+
+static void Pma_Fill(uint32_t seed)
+{
+  uint32_t i;
+
+  for (i = 0; i < PMA_WORDS; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    Pma[i] = PMA_HIGH_FILL | (seed >> 16);
+  }
+  memcpy(PmaRef, Pma, sizeof(Pma));
+}
+
+static uint32_t Test_Write(uint32_t align, uint32_t addr, uint32_t len)
+{
+  static uint32_t src32[USB_PMA_SIZE/4 + 2];
+  uint8_t *src = (uint8_t *)src32 + align;
+  uint32_t i, half = addr / 2;
+
+  for (i = 0; i < len + 1; i++)
+    src[i] = (uint8_t)(i * 7 + len + align);
+  Pma_Fill(len * 4 + align);
+  UserToPMABufferCopy(src, addr, len);
+  Ref_UserToPMABufferCopy(src, addr, len);
+
+  for (i = 0; i < PMA_WORDS; i++)
+  {
+    if ((Pma[i] & 0xFFFF0000u) != PMA_HIGH_FILL)
+      return 1;                                   //upper half touched, not a halfword store
+    if ((i < half) || (i >= half + len / 2 + (len & 1)))
+    {
+      if (Pma[i] != PmaRef[i])
+        return 1;                                 //written outside the buffer
+    }
+    else if ((len & 1) && (i == half + len / 2))
+    {
+      if ((Pma[i] & 0xFF) != (PmaRef[i] & 0xFF))
+        return 1;                                 //odd last byte
+    }
+    else if ((Pma[i] & 0xFFFF) != (PmaRef[i] & 0xFFFF))
+      return 1;
+  }
+  return 0;
+}
+
+static uint32_t Test_Read(uint32_t align, uint32_t addr, uint32_t len)
+{
+  static uint8_t dst32[USB_PMA_SIZE + 2*USR_GUARD + 4] __attribute__((aligned(4)));
+  static uint8_t ref32[USB_PMA_SIZE + 2*USR_GUARD + 4] __attribute__((aligned(4)));
+  uint8_t *dst = dst32 + USR_GUARD + align;
+  uint8_t *ref = ref32 + USR_GUARD + align;
+  uint32_t i;
+
+  Pma_Fill(len * 4 + align + 1);
+  memset(dst32, USR_FILL, sizeof(dst32));
+  memset(ref32, USR_FILL, sizeof(ref32));
+  PMAToUserBufferCopy(dst, addr, len);
+  Ref_PMAToUserBufferCopy(ref, addr, len);
+
+  if (memcmp(dst, ref, len) != 0)
+    return 1;
+  for (i = 0; i < sizeof(dst32); i++)
+  {
+    if (((dst32 + i < dst) || (dst32 + i >= dst + len)) && (dst32[i] != USR_FILL))
+      return 1;                                   //written outside the buffer
+  }
+  return 0;
+}
+
+int main(void)
+{
+  static const uint16_t addr[] = {0, 2, 0x40, 0x102, 0x1F0};
+  uint32_t a, k, len, cases = 0, fail = 0;
+
+  PMAAddr = (uintptr_t)Pma;
+  for (k = 0; k < sizeof(addr) / sizeof(addr[0]); k++)
+  {
+    for (a = 0; a < 4; a++)
+    {
+      for (len = 0; addr[k] + len <= USB_PMA_SIZE; len++)
+      {
+        if (Test_Write(a, addr[k], len))
+        {
+          printf("UserToPMABufferCopy: align %u addr 0x%03X len %u\n", a, addr[k], len);
+          fail++;
+        }
+        if (Test_Read(a, addr[k], len))
+        {
+          printf("PMAToUserBufferCopy: align %u addr 0x%03X len %u\n", a, addr[k], len);
+          fail++;
+        }
+        cases += 2;
+      }
+    }
+  }
+  printf("%u cases, %u failed\n", cases, fail);
+  return fail != 0;
+}
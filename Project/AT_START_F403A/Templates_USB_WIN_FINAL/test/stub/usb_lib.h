@@ -0,0 +1,10 @@
+//Host stand-in for the library usb_lib.h, only what usb_mem.c needs
+//The PMA base is a variable pointing at the simulated PMA instead of 0x40006000
+#ifndef __USB_LIB_H
+#define __USB_LIB_H
+#include <stdint.h>
+#include "usb_mem.h"
+
+extern uintptr_t PMAAddr;
+
+#endif
@@ -0,0 +1,250 @@
+//Host test of the configuration descriptor in usb_desc.c
+//The descriptor is walked by bLength and every count and total a host relies on is
+//recounted from the descriptors that follow it:
+//  config wTotalLength and bNumInterfaces
+//  IAD bFirstInterface/bInterfaceCount against the interfaces up to the next IAD
+//  bNumEndpoints of every alternate setting
+//  VC header, VS input header and AC header wTotalLength against the class specific
+//  descriptors they cover, bInCollection/baInterfaceNr and bNumFormats
+//  bNumFrameDescriptors of every format, frame and format indexes counting from 1
+//Rerun after changing the build switches in usb_desc.h (UVC_BULK_MODE, UVC_REPEAT_FRAME,
+//UAC_MIC_ENABLE).
+//Build and run from this directory:
+//  gcc -Wall -DAT32F403AVGT7 -DUSE_STDPERIPH_DRIVER -DAT_START_F403A_V1_0 -I../USB_APP -I../drivers -I.. -I../../../AT32_Board -I../../Templates -I../../../../Libraries/AT32F4xx_StdPeriph_Driver/inc -I../../../../Libraries/CMSIS/CM4/CoreSupport -I../../../../Libraries/CMSIS/CM4/DeviceSupport -I../../../../Middlewares/AT32_USB-FS-Device_Driver/inc -o usb_desc_test usb_desc_test.c && ./usb_desc_test
+//return: 0 when the descriptor is consistent
+#include <stdio.h>
+#include "usb_desc.c"
+
+#define DESC_CONFIG             0x02
+#define DESC_INTERFACE          0x04
+#define DESC_ENDPOINT           0x05
+#define DESC_IAD                0x0B
+#define DESC_CS_INTERFACE       0x24
+
+#define CLASS_AUDIO             0x01
+#define CLASS_VIDEO             0x0E
+#define SUBCLASS_CONTROL        0x01        //VideoControl and AudioControl
+#define SUBCLASS_STREAMING      0x02        //VideoStreaming
+#define CS_HEADER               0x01        //VC_HEADER, VS_INPUT_HEADER and AC HEADER
+
+#define VS_SUB_FORMAT_YUY2      0x04
+#define VS_SUB_FRAME_YUY2       0x05
+#define VS_SUB_FORMAT_MJPEG     0x06
+#define VS_SUB_FRAME_MJPEG      0x07
+
+#define MAX_INTERFACES          8
+
+
+static const u8 *Desc;
+static u32 DescLen;
+static u32 FailCnt = 0;
+static u8 Listed[MAX_INTERFACES];           //named by a baInterfaceNr
+
+static void Fail(u32 pos, const char *what, u32 found, u32 expected)
+{
+    printf("offset %3u: %s is %u, expected %u\n", pos, what, found, expected);
+    FailCnt++;
+}
+
+static u16 Word(u32 pos)
+{
+    return Desc[pos] | (Desc[pos + 1] << 8);
+}
+
+//bytes of the class specific interface descriptors from pos on, up to the first other one
+static u32 CS_Span(u32 pos)
+{
+    u32 len = 0;
+
+    while ((pos < DescLen) && (Desc[pos + 1] == DESC_CS_INTERFACE))
+    {
+        len += Desc[pos];
+        pos += Desc[pos];
+    }
+    return len;
+}
+
+//interface number of the next interface descriptor after pos, 0xFF if none
+static u8 Next_Interface(u32 pos)
+{
+    for (pos += Desc[pos]; pos < DescLen; pos += Desc[pos])
+    {
+        if (Desc[pos + 1] == DESC_INTERFACE)
+            return Desc[pos + 2];
+    }
+    return 0xFF;
+}
+
+//The header must cover its own class specific block, the interfaces it lists have to
+//follow the one it belongs to, main() checks they exist
+static void Check_Collection(u32 pos, u32 total, u32 count, u32 list, const u8 seen[])
+{
+    u32 i, nr, n = Desc[pos + count];
+
+    if (total != CS_Span(pos))
+        Fail(pos, "header wTotalLength", total, CS_Span(pos));
+    if (Desc[pos] != list + n)
+        Fail(pos, "header bLength for bInCollection", Desc[pos], list + n);
+    for (i = 0; i < n; i++)
+    {
+        nr = Desc[pos + list + i];
+        if ((nr >= MAX_INTERFACES) || seen[nr])
+            Fail(pos + list + i, "baInterfaceNr, not a later interface", nr, 0);
+        else
+            Listed[nr] = 1;
+    }
+}
+
+//bNumFormats and every bNumFrameDescriptors against the descriptors that follow
+static void Check_Formats(u32 pos)
+{
+    u32 end = pos + CS_Span(pos);
+    u32 formats = 0, frames = 0, expected = 0, at = pos;
+    u32 p;
+
+    for (p = pos + Desc[pos]; p < end; p += Desc[p])
+    {
+        switch (Desc[p + 2])
+        {
+        case VS_SUB_FORMAT_YUY2:
+        case VS_SUB_FORMAT_MJPEG:
+            if (formats && (frames != expected))
+                Fail(at, "bNumFrameDescriptors", expected, frames);
+            formats++;
+            if (Desc[p + 3] != formats)
+                Fail(p, "bFormatIndex", Desc[p + 3], formats);
+            expected = Desc[p + 4];
+            frames = 0;
+            at = p;
+            break;
+        case VS_SUB_FRAME_YUY2:
+        case VS_SUB_FRAME_MJPEG:
+            if ((Desc[p + 2] - 1) != Desc[at + 2])
+                Fail(p, "frame subtype after its format", Desc[p + 2], Desc[at + 2] + 1);
+            frames++;
+            if (Desc[p + 3] != frames)
+                Fail(p, "bFrameIndex", Desc[p + 3], frames);
+            if ((Desc[p + 25] != 0) && (Desc[p] != 26 + 4 * Desc[p + 25]))
+                Fail(p, "frame bLength for bFrameIntervalType", Desc[p], 26 + 4 * Desc[p + 25]);
+            break;
+        default:
+            break;
+        }
+    }
+    if (formats && (frames != expected))
+        Fail(at, "bNumFrameDescriptors", expected, frames);
+    if (Desc[pos + 3] != formats)
+        Fail(pos, "bNumFormats", Desc[pos + 3], formats);
+    if (Desc[pos] != 13 + Desc[pos + 3] * Desc[pos + 12])
+        Fail(pos, "input header bLength for bNumFormats", Desc[pos], 13 + Desc[pos + 3] * Desc[pos + 12]);
+}
+
+int main(void)
+{
+    u8 seen[MAX_INTERFACES] = {0};
+    u32 pos, ifaces = 0, endpoints = 0;
+    u32 intf = 0, eps = 0, iad = 0, iadIfaces = 0;
+    u8 cls = 0, sub = 0, alt = 0, num = 0xFF;
+
+    Desc = Camera_ConfigDescriptor;
+    DescLen = sizeof(Camera_ConfigDescriptor);
+
+    if (Desc[1] != DESC_CONFIG)
+        Fail(0, "bDescriptorType", Desc[1], DESC_CONFIG);
+    if (Word(2) != DescLen)
+        Fail(0, "config wTotalLength", Word(2), DescLen);
+
+    for (pos = 0; pos < DescLen; pos += Desc[pos])
+    {
+        if (Desc[pos] < 2)
+        {
+            Fail(pos, "bLength", Desc[pos], 2);
+            return 1;
+        }
+        if (pos + Desc[pos] > DescLen)
+        {
+            Fail(pos, "descriptor end", pos + Desc[pos], DescLen);
+            return 1;
+        }
+
+        switch (Desc[pos + 1])
+        {
+        case DESC_IAD:
+            if (iad && (iadIfaces != Desc[iad + 3]))
+                Fail(iad, "IAD bInterfaceCount", Desc[iad + 3], iadIfaces);
+            iad = pos;
+            iadIfaces = 0;
+            if (Next_Interface(pos) != Desc[pos + 2])
+                Fail(pos, "IAD bFirstInterface", Desc[pos + 2], Next_Interface(pos));
+            break;
+
+        case DESC_INTERFACE:
+            if (intf && (eps != Desc[intf + 4]))
+                Fail(intf, "bNumEndpoints", Desc[intf + 4], eps);
+            intf = pos;
+            eps = 0;
+            alt = Desc[pos + 3];
+            cls = Desc[pos + 5];
+            sub = Desc[pos + 6];
+            if (Desc[pos + 2] >= MAX_INTERFACES)
+            {
+                Fail(pos, "bInterfaceNumber", Desc[pos + 2], MAX_INTERFACES - 1);
+                return 1;
+            }
+            if (Desc[pos + 2] != num)
+            {
+                num = Desc[pos + 2];
+                if (seen[num] || (alt != 0))
+                    Fail(pos, "interface out of order", num, ifaces);
+                seen[num] = 1;
+                ifaces++;
+                iadIfaces++;
+                if (iad && ((num < Desc[iad + 2]) || (num >= Desc[iad + 2] + Desc[iad + 3])))
+                    Fail(pos, "interface outside its IAD", num, Desc[iad + 2]);
+            }
+            break;
+
+        case DESC_ENDPOINT:
+            eps++;
+            endpoints++;
+            if ((Desc[pos + 2] & 0x0F) >= EP_NUM)
+                Fail(pos, "endpoint number", Desc[pos + 2] & 0x0F, EP_NUM - 1);
+            break;
+
+        case DESC_CS_INTERFACE:
+            //a header is the first class specific descriptor of the alternate setting
+            if ((Desc[pos + 2] != CS_HEADER) || (intf + Desc[intf] != pos) || (alt != 0))
+                break;
+            if ((cls == CLASS_VIDEO) && (sub == SUBCLASS_CONTROL))
+                Check_Collection(pos, Word(pos + 5), 11, 12, seen);
+            else if ((cls == CLASS_VIDEO) && (sub == SUBCLASS_STREAMING))
+            {
+                if (Word(pos + 4) != CS_Span(pos))
+                    Fail(pos, "VS input header wTotalLength", Word(pos + 4), CS_Span(pos));
+                Check_Formats(pos);
+            }
+            else if ((cls == CLASS_AUDIO) && (sub == SUBCLASS_CONTROL))
+                Check_Collection(pos, Word(pos + 5), 7, 8, seen);
+            break;
+
+        default:
+            break;
+        }
+    }
+    if (intf && (eps != Desc[intf + 4]))
+        Fail(intf, "bNumEndpoints", Desc[intf + 4], eps);
+    if (iad && (iadIfaces != Desc[iad + 3]))
+        Fail(iad, "IAD bInterfaceCount", Desc[iad + 3], iadIfaces);
+    if (pos != DescLen)
+        Fail(pos, "walk end", pos, DescLen);
+    if (Desc[4] != ifaces)
+        Fail(0, "config bNumInterfaces", Desc[4], ifaces);
+    for (num = 0; num < MAX_INTERFACES; num++)
+    {
+        if (Listed[num] && !seen[num])
+            Fail(0, "baInterfaceNr without interface", num, 0);
+    }
+
+    printf("%u bytes, %u interfaces, %u endpoints, %u errors\n", DescLen, ifaces, endpoints, FailCnt);
+    return FailCnt != 0;
+}